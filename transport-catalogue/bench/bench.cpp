@@ -0,0 +1,656 @@
+// bench.cpp
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++20 -O2 -pthread -I. bench/bench.cpp $(ls *.cpp | grep -v main.cpp) -o bench
+//
+// Запуск: ./bench РЕЖИМ [--stops N] [--buses N] [--bus-stops N] [--queries N] [--maps N] [--seed N]
+// Все режимы работают на случайной сети из GenerateInput, одинаковой при одинаковых параметрах
+
+#include "geo.h"
+#include "json.h"
+#include "json_reader.h"
+#include "json_scan.h"
+#include "json_tape.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+    using namespace std::literals;
+    using namespace transport;
+    using namespace transport::catalogue;
+
+    struct Options {
+        std::string mode;
+        int stop_count = 1200;      // --stops N
+        int bus_count = 100;        // --buses N
+        int bus_stop_count = 20;    // --bus-stops N: остановок в маршруте, не считая повтора первой у кольцевых
+        int query_count = 2000;     // --queries N: число маршрутов между случайными остановками и запросов в stat_requests
+        int map_count = 0;          // --maps N: сколько запросов Map добавить в stat_requests
+        unsigned seed = 1;          // --seed N
+    };
+
+    Options ParseOptions(int argc, char** argv) {
+        if (argc < 2) {
+            throw std::invalid_argument("Mode is not specified"s);
+        }
+        Options options;
+        options.mode = argv[1];
+        for (int i = 2; i < argc; ++i) {
+            if (argv[i] == "--stops"sv && i + 1 < argc) {
+                options.stop_count = std::atoi(argv[++i]);
+            }
+            else if (argv[i] == "--buses"sv && i + 1 < argc) {
+                options.bus_count = std::atoi(argv[++i]);
+            }
+            else if (argv[i] == "--bus-stops"sv && i + 1 < argc) {
+                options.bus_stop_count = std::atoi(argv[++i]);
+            }
+            else if (argv[i] == "--queries"sv && i + 1 < argc) {
+                options.query_count = std::atoi(argv[++i]);
+            }
+            else if (argv[i] == "--maps"sv && i + 1 < argc) {
+                options.map_count = std::atoi(argv[++i]);
+            }
+            else if (argv[i] == "--seed"sv && i + 1 < argc) {
+                options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else {
+                throw std::invalid_argument("Unknown argument: "s + argv[i]);
+            }
+        }
+        if (options.stop_count < 2 || options.bus_count < 1 || options.bus_stop_count < 2 || options.query_count < 1) {
+            throw std::invalid_argument("Network is too small"s);
+        }
+        return options;
+    }
+
+    std::string StopName(int index) {
+        return "Stop "s + std::to_string(index);
+    }
+
+    std::string BusName(int index) {
+        return "Bus "s + std::to_string(index);
+    }
+
+    json::Dict MakeRenderSettings() {
+        return json::Dict{
+            { "width"s, 1200.0 },
+            { "height"s, 1200.0 },
+            { "padding"s, 50.0 },
+            { "stop_radius"s, 5.0 },
+            { "line_width"s, 14.0 },
+            { "bus_label_font_size"s, 20 },
+            { "bus_label_offset"s, json::Array{ 7.0, 15.0 } },
+            { "stop_label_font_size"s, 20 },
+            { "stop_label_offset"s, json::Array{ 7.0, -3.0 } },
+            { "underlayer_color"s, json::Array{ 255, 255, 255, 0.85 } },
+            { "underlayer_width"s, 3.0 },
+            { "color_palette"s, json::Array{ "green"s, json::Array{ 255, 160, 0 }, "red"s } },
+        };
+    }
+
+    // Запросы Bus, Stop и Route по очереди, запросы Map расставлены среди них равномерно
+    json::Array MakeStatRequests(const Options& options) {
+        std::mt19937 random(options.seed + 2);
+        std::uniform_int_distribution<int> random_stop(0, options.stop_count - 1);
+        std::uniform_int_distribution<int> random_bus(0, options.bus_count - 1);
+        json::Array requests;
+        int next_map = 0;
+        for (int i = 0; i < options.query_count; ++i) {
+            while (next_map < options.map_count && static_cast<long long>(next_map) * options.query_count <= static_cast<long long>(i) * options.map_count) {
+                requests.emplace_back(json::Dict{ { "id"s, static_cast<int>(requests.size()) }, { "type"s, "Map"s } });
+                ++next_map;
+            }
+            const int id = static_cast<int>(requests.size());
+            switch (i % 3) {
+            case 0:
+                requests.emplace_back(json::Dict{ { "id"s, id }, { "type"s, "Bus"s }, { "name"s, BusName(random_bus(random)) } });
+                break;
+            case 1:
+                requests.emplace_back(json::Dict{ { "id"s, id }, { "type"s, "Stop"s }, { "name"s, StopName(random_stop(random)) } });
+                break;
+            default:
+                requests.emplace_back(json::Dict{
+                    { "id"s, id },
+                    { "type"s, "Route"s },
+                    { "from"s, StopName(random_stop(random)) },
+                    { "to"s, StopName(random_stop(random)) },
+                });
+                break;
+            }
+        }
+        return requests;
+    }
+
+    /*
+     * Остановки разбросаны по квадрату примерно 30 на 30 км, маршрут - цепочка случайных
+     * остановок, каждый второй автобус кольцевой. Расстояние по дороге задаётся для каждого
+     * перегона и в 1.1-1.5 раза длиннее расстояния по прямой
+     */
+    std::string GenerateInput(const Options& options) {
+        std::mt19937 random(options.seed);
+        std::uniform_real_distribution<double> latitude(55.60, 55.87);
+        std::uniform_real_distribution<double> longitude(37.40, 37.87);
+        std::uniform_real_distribution<double> detour(1.1, 1.5);
+        std::uniform_int_distribution<int> random_stop(0, options.stop_count - 1);
+
+        std::vector<geo::Coordinates> coordinates(options.stop_count);
+        for (auto& point : coordinates) {
+            point = { latitude(random), longitude(random) };
+        }
+
+        std::vector<json::Dict> road_distances(options.stop_count);
+        json::Array buses;
+        for (int bus = 0; bus < options.bus_count; ++bus) {
+            const bool is_roundtrip = bus % 2 == 0;
+            std::vector<int> route;
+            while (static_cast<int>(route.size()) < options.bus_stop_count) {
+                const int stop = random_stop(random);
+                if (route.empty() || stop != route.back()) {
+                    route.push_back(stop);
+                }
+            }
+            if (is_roundtrip) {
+                route.push_back(route.front());
+            }
+
+            json::Array stops;
+            for (size_t i = 0; i < route.size(); ++i) {
+                stops.emplace_back(StopName(route[i]));
+                if (i > 0 && route[i - 1] != route[i]) {
+                    const double distance = geo::ComputeDistance(coordinates[route[i - 1]], coordinates[route[i]]);
+                    road_distances[route[i - 1]].emplace(StopName(route[i]), static_cast<int>(distance * detour(random)) + 1);
+                }
+            }
+            buses.emplace_back(json::Dict{
+                { "type"s, "Bus"s },
+                { "name"s, BusName(bus) },
+                { "stops"s, std::move(stops) },
+                { "is_roundtrip"s, is_roundtrip },
+            });
+        }
+
+        json::Array base_requests;
+        for (int stop = 0; stop < options.stop_count; ++stop) {
+            base_requests.emplace_back(json::Dict{
+                { "type"s, "Stop"s },
+                { "name"s, StopName(stop) },
+                { "latitude"s, coordinates[stop].lat },
+                { "longitude"s, coordinates[stop].lng },
+                { "road_distances"s, std::move(road_distances[stop]) },
+            });
+        }
+        for (auto& bus : buses) {
+            base_requests.push_back(std::move(bus));
+        }
+
+        json::Dict root{
+            { "base_requests"s, std::move(base_requests) },
+            { "routing_settings"s, json::Dict{ { "bus_velocity"s, 40 }, { "bus_wait_time"s, 6 } } },
+            { "render_settings"s, MakeRenderSettings() },
+            { "stat_requests"s, MakeStatRequests(options) },
+        };
+        std::ostringstream output;
+        json::Print(json::Document(json::Node(std::move(root))), output);
+        return output.str();
+    }
+
+    // Заполняет справочник из сгенерированного входа и возвращает остальные разделы
+    json::Document LoadInput(const std::string& input, TransportCatalogue& catalogue) {
+        std::istringstream stream(input);
+        return JsonReader(catalogue).LoadData(stream);
+    }
+
+    std::vector<std::pair<std::string, std::string>> MakeRouteQueries(const Options& options) {
+        std::mt19937 random(options.seed + 1);
+        std::uniform_int_distribution<int> random_stop(0, options.stop_count - 1);
+        std::vector<std::pair<std::string, std::string>> queries;
+        queries.reserve(options.query_count);
+        for (int i = 0; i < options.query_count; ++i) {
+            queries.emplace_back(StopName(random_stop(random)), StopName(random_stop(random)));
+        }
+        return queries;
+    }
+
+    template <typename Action>
+    double MeasureMs(Action action) {
+        const auto start = std::chrono::steady_clock::now();
+        action();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Лучшее из нескольких измерений: так меньше влияют кэши и соседние процессы
+    template <typename Action>
+    double BestOfMs(int runs, Action action) {
+        double best = MeasureMs(action);
+        for (int i = 1; i < runs; ++i) {
+            best = std::min(best, MeasureMs(action));
+        }
+        return best;
+    }
+
+    double MegabytesPerSecond(size_t bytes, double ms) {
+        return bytes / ms / 1000.0;
+    }
+
+    // Тот же документ без пробелов и переводов строк вне строковых значений
+    std::string Compact(std::string_view text) {
+        std::string result;
+        result.reserve(text.size());
+        bool in_string = false;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const char c = text[i];
+            if (in_string) {
+                result += c;
+                if (c == '\\' && i + 1 < text.size()) {
+                    result += text[++i];
+                }
+                else if (c == '"') {
+                    in_string = false;
+                }
+            }
+            else if (c == '"') {
+                in_string = true;
+                result += c;
+            }
+            else if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    struct RouterMeasurement {
+        size_t edge_count = 0;
+        double build_ms = 0;
+        double route_us = 0;
+        std::vector<double> total_times;  // -1, если маршрута нет
+    };
+
+    RouterMeasurement MeasureRouter(const TransportCatalogue& catalogue, const RoutingSettings& settings,
+        const std::vector<std::pair<std::string, std::string>>& queries) {
+        RouterMeasurement result;
+        std::optional<TransportRouter> router;
+        result.build_ms = MeasureMs([&] { router.emplace(settings, catalogue); });
+        result.edge_count = router->GetEdgeCount();
+        result.total_times.reserve(queries.size());
+        const double routes_ms = MeasureMs([&] {
+            for (const auto& [from, to] : queries) {
+                const auto route = router->GetRoute(from, to);
+                result.total_times.push_back(route ? std::get<0>(*route) : -1.0);
+            }
+        });
+        result.route_us = routes_ms * 1000 / queries.size();
+        return result;
+    }
+
+    void PrintRouter(std::string_view name, const RouterMeasurement& measurement) {
+        std::cout << std::left << std::setw(28) << name << std::right
+            << std::setw(8) << measurement.edge_count << " edges   build "
+            << std::fixed << std::setprecision(1) << std::setw(9) << measurement.build_ms << " ms   route "
+            << std::setw(8) << measurement.route_us << " us" << std::endl;
+    }
+
+    // Число запросов, на которых время маршрута отличается от эталонного
+    size_t CountMismatches(const RouterMeasurement& expected, const RouterMeasurement& actual) {
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.total_times.size(); ++i) {
+            mismatches += std::abs(expected.total_times[i] - actual.total_times[i]) > 1e-6;
+        }
+        return mismatches;
+    }
+
+    // Построение маршрутизатора и среднее время GetRoute: Дейкстра против сжатия иерархий
+    void RunRouting(const Options& options) {
+        TransportCatalogue catalogue;
+        const json::Document doc = LoadInput(GenerateInput(options), catalogue);
+        const auto queries = MakeRouteQueries(options);
+
+        RoutingSettings settings = GetRoutingSettings(doc);
+        const auto dijkstra = MeasureRouter(catalogue, settings, queries);
+        PrintRouter("dijkstra", dijkstra);
+        settings.router_mode = RouterMode::CONTRACTION_HIERARCHIES;
+        const auto hierarchies = MeasureRouter(catalogue, settings, queries);
+        PrintRouter("contraction hierarchies", hierarchies);
+        std::cout << "total_time differs on " << CountMismatches(dijkstra, hierarchies) << " of " << queries.size() << " routes" << std::endl;
+    }
+
+    // Модели графа "пары остановок" и "перегоны" при обоих способах поиска; эталон - пары остановок с Дейкстрой
+    void RunGraphModel(const Options& options) {
+        TransportCatalogue catalogue;
+        const json::Document doc = LoadInput(GenerateInput(options), catalogue);
+        const auto queries = MakeRouteQueries(options);
+
+        RoutingSettings settings = GetRoutingSettings(doc);
+        std::optional<RouterMeasurement> expected;
+        for (const auto graph_model : { GraphModel::STOP_PAIRS, GraphModel::RIDE_SEGMENTS }) {
+            for (const auto router_mode : { RouterMode::DIJKSTRA, RouterMode::CONTRACTION_HIERARCHIES }) {
+                settings.graph_model = graph_model;
+                settings.router_mode = router_mode;
+                const auto measurement = MeasureRouter(catalogue, settings, queries);
+                PrintRouter((graph_model == GraphModel::STOP_PAIRS ? "stop pairs"s : "ride segments"s)
+                    + (router_mode == RouterMode::DIJKSTRA ? ", dijkstra"s : ", hierarchies"s), measurement);
+                if (!expected) {
+                    expected = measurement;
+                }
+                else if (const size_t mismatches = CountMismatches(*expected, measurement); mismatches > 0) {
+                    std::cout << "    total_time differs on " << mismatches << " of " << queries.size() << " routes" << std::endl;
+                }
+            }
+        }
+    }
+
+    // Скорость json::Load из буфера и из потока на отформатированном и сжатом документе
+    void RunParse(const Options& options) {
+        const std::string indented = GenerateInput(options);
+        const std::string compact = Compact(indented);
+        for (const auto& [name, text] : { std::pair{ "indented"sv, &indented }, std::pair{ "compact"sv, &compact } }) {
+            const double buffer_ms = BestOfMs(5, [&] { json::Load(std::string_view(*text)); });
+            const double stream_ms = BestOfMs(5, [&] {
+                std::istringstream input(*text);
+                json::Load(input);
+            });
+            std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(2)
+                << std::setw(7) << text->size() / 1e6 << " MB   string_view "
+                << std::setprecision(1) << std::setw(6) << MegabytesPerSecond(text->size(), buffer_ms) << " MB/s   istream "
+                << std::setw(6) << MegabytesPerSecond(text->size(), stream_ms) << " MB/s" << std::endl;
+        }
+    }
+
+    /*
+     * ProcessRequests на 1, 2 и 4 потоках; ответы должны совпадать побайтно. Для каждого прогона
+     * заводится новый JsonReader, поэтому в замер входит и построение маршрутизатора
+     */
+    void RunThreads(const Options& options) {
+        TransportCatalogue catalogue;
+        const json::Document doc = LoadInput(GenerateInput(options), catalogue);
+
+        std::string expected;
+        for (const size_t thread_count : { 1, 2, 4 }) {
+            std::string responses;
+            const double ms = BestOfMs(3, [&] {
+                std::ostringstream output;
+                JsonReader(catalogue).ProcessRequests(doc, output, thread_count);
+                responses = output.str();
+            });
+            std::cout << thread_count << " threads " << std::fixed << std::setprecision(1) << std::setw(9) << ms << " ms";
+            if (thread_count == 1) {
+                expected = std::move(responses);
+            }
+            else if (responses != expected) {
+                std::cout << "   responses differ from 1 thread";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // Холодный старт: разбор JSON и построение маршрутизатора против загрузки снимка
+    void RunSnapshot(const Options& options) {
+        const std::string input = GenerateInput(options);
+        TransportCatalogue catalogue;
+        const json::Document doc = LoadInput(input, catalogue);
+        const double load_ms = BestOfMs(3, [&] {
+            TransportCatalogue fresh_catalogue;
+            LoadInput(input, fresh_catalogue);
+        });
+
+        for (const bool hierarchies : { false, true }) {
+            json::Dict routing_settings = doc.GetRoot().AsDict().at("routing_settings"s).AsDict();
+            routing_settings["use_contraction_hierarchies"s] = hierarchies;
+            const json::Document settings_doc(json::Node(json::Dict{ { "routing_settings"s, std::move(routing_settings) } }));
+
+            const double build_ms = MeasureMs([&] { TransportRouter(GetRoutingSettings(settings_doc), catalogue); });
+            std::ostringstream output;
+            JsonReader(catalogue).SaveSnapshot(output, settings_doc);
+            const std::string snapshot = output.str();
+            const double snapshot_ms = BestOfMs(3, [&] {
+                TransportCatalogue loaded_catalogue;
+                std::istringstream stream(snapshot);
+                JsonReader(loaded_catalogue).LoadSnapshot(stream);
+            });
+
+            std::cout << std::left << std::setw(26) << (hierarchies ? "contraction hierarchies" : "dijkstra") << std::right
+                << std::fixed << std::setprecision(1) << "json " << std::setw(7) << load_ms << " ms + router "
+                << std::setw(8) << build_ms << " ms   snapshot " << std::setw(6) << snapshot_ms << " ms ("
+                << snapshot.size() / 1e6 << " MB)" << std::endl;
+        }
+    }
+
+    // Обработчик, отбрасывающий события: остаётся только сам разбор
+    class NullHandler final : public json::Handler {
+    public:
+        void Null() override {}
+        void Bool(bool) override {}
+        void Int(int) override {}
+        void Double(double) override {}
+        void String(std::string_view) override {}
+        void StartArray() override {}
+        void EndArray() override {}
+        void StartDict() override {}
+        void Key(std::string_view) override {}
+        void EndDict() override {}
+    };
+
+    std::string_view ScanLevelName(json::ScanLevel level) {
+        switch (level) {
+        case json::ScanLevel::SCALAR:
+            return "scalar"sv;
+        case json::ScanLevel::SSE2:
+            return "sse2"sv;
+        case json::ScanLevel::AVX2:
+            return "avx2"sv;
+        }
+        return {};
+    }
+
+    /*
+     * Просмотр входа на каждом уровне Scanner: пропуск пробелов и поиск конца строки по очереди,
+     * через те же встроенные функции, что и в парсере, затем разбор целиком - без обработки, в ленту и в дерево
+     */
+    void RunScan(const Options& options) {
+        const std::string input = GenerateInput(options);
+        const char* const end = input.data() + input.size();
+        std::cout << "input " << std::fixed << std::setprecision(2) << input.size() / 1e6
+            << " MB, best scan level " << ScanLevelName(json::GetBestScanLevel()) << std::endl;
+
+        for (const auto level : { json::ScanLevel::SCALAR, json::ScanLevel::SSE2, json::ScanLevel::AVX2 }) {
+            if (level > json::GetBestScanLevel()) {
+                continue;
+            }
+            const json::Scanner& scanner = json::GetScanner(level);
+            size_t stops = 0;
+            const double ms = BestOfMs(5, [&] {
+                stops = 0;
+                for (const char* position = input.data(); position < end; ++stops) {
+                    position = json::SkipSpaces(position, end, scanner);
+                    if (position < end) {
+                        position = json::FindStringStop(position + 1, end, scanner) + 1;
+                    }
+                }
+            });
+            std::cout << std::left << std::setw(10) << ScanLevelName(level) << std::right << std::setprecision(1)
+                << std::setw(8) << MegabytesPerSecond(input.size(), ms) << " MB/s   " << stops << " stops" << std::endl;
+        }
+
+        const double parse_ms = BestOfMs(5, [&] {
+            NullHandler handler;
+            json::Parse(std::string_view(input), handler);
+        });
+        const double tape_ms = BestOfMs(5, [&] { json::LoadTape(std::string_view(input)); });
+        const double dom_ms = BestOfMs(5, [&] { json::Load(std::string_view(input)); });
+        std::cout << std::setprecision(1) << "Parse " << MegabytesPerSecond(input.size(), parse_ms) << " MB/s   LoadTape "
+            << tape_ms << " ms   Load " << dom_ms << " ms" << std::endl;
+    }
+
+    /*
+     * Вывод чисел: карта через RenderMap и ответ в духе Route с ROUTE_ITEM_COUNT элементами
+     * через json::Writer, в обоих почти весь текст - числа с плавающей точкой
+     */
+    void RunFormat(const Options& options) {
+        constexpr int ROUTE_ITEM_COUNT = 400000;
+
+        TransportCatalogue catalogue;
+        const json::Document doc = LoadInput(GenerateInput(options), catalogue);
+        const MapRenderer renderer(GetRenderSettings(doc));
+        size_t map_size = 0;
+        const double map_ms = BestOfMs(5, [&] {
+            std::ostringstream output;
+            renderer.RenderMap(catalogue, output);
+            map_size = output.str().size();
+        });
+
+        std::mt19937 random(options.seed + 3);
+        std::uniform_real_distribution<double> time(0.0, 60.0);
+        json::Array items;
+        items.reserve(ROUTE_ITEM_COUNT);
+        for (int i = 0; i < ROUTE_ITEM_COUNT; ++i) {
+            if (i % 2 == 0) {
+                items.emplace_back(json::Dict{ { "type"s, "Wait"s }, { "stop_name"s, StopName(i % options.stop_count) }, { "time"s, time(random) } });
+            }
+            else {
+                items.emplace_back(json::Dict{
+                    { "type"s, "Bus"s },
+                    { "bus"s, BusName(i % options.bus_count) },
+                    { "span_count"s, i % 7 + 1 },
+                    { "time"s, time(random) },
+                });
+            }
+        }
+        const json::Node route(json::Dict{ { "request_id"s, 1 }, { "total_time"s, 12345.678 }, { "items"s, std::move(items) } });
+        size_t route_size = 0;
+        const double route_ms = BestOfMs(5, [&] {
+            std::ostringstream output;
+            json::Writer(output).Value(route);
+            route_size = output.str().size();
+        });
+
+        std::cout << std::fixed << std::setprecision(2)
+            << "map   " << std::setw(6) << map_size / 1e6 << " MB " << std::setprecision(1) << std::setw(8) << map_ms << " ms "
+            << std::setw(7) << MegabytesPerSecond(map_size, map_ms) << " MB/s" << std::endl
+            << std::setprecision(2)
+            << "route " << std::setw(6) << route_size / 1e6 << " MB " << std::setprecision(1) << std::setw(8) << route_ms << " ms "
+            << std::setw(7) << MegabytesPerSecond(route_size, route_ms) << " MB/s" << std::endl;
+    }
+
+    std::string_view SimdLevelName(geo::SimdLevel level) {
+        switch (level) {
+        case geo::SimdLevel::SCALAR:
+            return "scalar"sv;
+        case geo::SimdLevel::SSE2:
+            return "sse2"sv;
+        case geo::SimdLevel::AVX2:
+            return "avx2"sv;
+        }
+        return {};
+    }
+
+    // Длина ломаной из PATH_POINT_COUNT точек - маршрутов сети, повторённых друг за другом
+    void RunGeo(const Options& options) {
+        constexpr size_t PATH_POINT_COUNT = 1000000;
+
+        const json::Document doc = json::Load(GenerateInput(options));
+        std::unordered_map<std::string_view, geo::Coordinates> stops;
+        std::vector<const json::Array*> routes;
+        for (const auto& request : doc.GetRoot().AsDict().at("base_requests"s).AsArray()) {
+            const auto& fields = request.AsDict();
+            if (fields.at("type"s).AsString() == "Stop"s) {
+                stops.emplace(fields.at("name"s).AsString(), geo::Coordinates{ fields.at("latitude"s).AsDouble(), fields.at("longitude"s).AsDouble() });
+            }
+            else {
+                routes.push_back(&fields.at("stops"s).AsArray());
+            }
+        }
+        std::vector<geo::Coordinates> points;
+        points.reserve(PATH_POINT_COUNT);
+        for (size_t route = 0; points.size() < PATH_POINT_COUNT; route = (route + 1) % routes.size()) {
+            for (const auto& stop : *routes[route]) {
+                if (points.size() < PATH_POINT_COUNT) {
+                    points.push_back(stops.at(stop.AsString()));
+                }
+            }
+        }
+        geo::UnitPath path;
+        path.Reserve(points.size());
+        for (const auto& point : points) {
+            path.Add(geo::ToUnitVector(point));
+        }
+        const double segment_count = static_cast<double>(points.size() - 1);
+
+        double expected = 0;
+        const double coordinates_ms = BestOfMs(5, [&] {
+            expected = 0;
+            for (size_t i = 1; i < points.size(); ++i) {
+                expected += geo::ComputeDistance(points[i - 1], points[i]);
+            }
+        });
+        std::cout << std::left << std::setw(24) << "ComputeDistance" << std::right << std::fixed << std::setprecision(1)
+            << std::setw(7) << segment_count / coordinates_ms / 1000 << " M segments/s" << std::endl;
+
+        for (const auto level : { geo::SimdLevel::SCALAR, geo::SimdLevel::SSE2, geo::SimdLevel::AVX2 }) {
+            if (level > geo::GetBestSimdLevel()) {
+                continue;
+            }
+            double length = 0;
+            const double ms = BestOfMs(5, [&] { length = geo::ComputeLength(path, level); });
+            std::cout << std::left << std::setw(24) << "ComputeLength "s + std::string(SimdLevelName(level)) << std::right
+                << std::setprecision(1) << std::setw(7) << segment_count / ms / 1000 << " M segments/s   relative difference "
+                << std::scientific << std::setprecision(1) << std::abs(length - expected) / expected << std::fixed << std::endl;
+        }
+    }
+
+    struct Mode {
+        std::string_view name;
+        void (*run)(const Options& options);
+    };
+
+    constexpr Mode MODES[] = {
+        { "routing"sv, RunRouting },
+        { "graph-model"sv, RunGraphModel },
+        { "parse"sv, RunParse },
+        { "threads"sv, RunThreads },
+        { "snapshot"sv, RunSnapshot },
+        { "scan"sv, RunScan },
+        { "format"sv, RunFormat },
+        { "geo"sv, RunGeo },
+    };
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = ParseOptions(argc, argv);
+        for (const auto& mode : MODES) {
+            if (mode.name == options.mode) {
+                mode.run(options);
+                return 0;
+            }
+        }
+        throw std::invalid_argument("Unknown mode: "s + options.mode);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Modes:";
+        for (const auto& mode : MODES) {
+            std::cerr << ' ' << mode.name;
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,606 @@
+// contraction_hierarchy.h
+#pragma once
+
+#include "graph.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    /*
+     * Иерархия сжатий (Contraction Hierarchies).
+     * Предобработка один раз упорядочивает вершины по "важности" и сжимает их,
+     * добавляя рёбра-сокращения там, где без вершины пропал бы кратчайший путь.
+     * Запрос - двунаправленный Дейкстра только по рёбрам, ведущим вверх по рангу.
+     * Сокращения раскрываются обратно в рёбра исходного графа
+     */
+    template <typename Weight>
+    class ContractionHierarchy {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+        using ArcId = size_t;
+
+    public:
+        explicit ContractionHierarchy(const Graph& graph);
+
+        struct Path {
+            Weight weight;
+            std::vector<EdgeId> edges;
+        };
+
+        std::optional<Path> FindPath(VertexId from, VertexId to) const;
+
+        size_t GetShortcutCount() const {
+            return arcs_.size() - edge_count_;
+        }
+
+        // Сохранённая иерархия загружается без повторной предобработки;
+        // graph - тот же граф, по которому она была построена
+        void Save(std::ostream& output) const;
+        static ContractionHierarchy Load(const Graph& graph, std::istream& input);
+
+    private:
+        ContractionHierarchy() = default;
+
+        // Дуги с номерами меньше edge_count_ совпадают с рёбрами графа,
+        // остальные - сокращения из двух дуг
+        struct Arc {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            ArcId first = NO_ARC;
+            ArcId second = NO_ARC;
+        };
+
+        // Рёбра поиска в формате CSR: рёбра вершины v лежат в [offsets[v], offsets[v + 1])
+        struct SearchGraph {
+            std::vector<size_t> offsets;
+            std::vector<VertexId> targets;
+            std::vector<Weight> weights;
+            std::vector<ArcId> arcs;
+        };
+
+        struct QueueItem {
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const QueueItem& other) const {
+                return weight > other.weight;
+            }
+        };
+
+        struct SearchSide {
+            std::vector<Weight> weights;
+            std::vector<ArcId> parent_arcs;
+            std::vector<VertexId> touched;
+            std::vector<QueueItem> queue;
+
+            void Prepare(size_t vertex_count);
+            void Reach(VertexId vertex, Weight weight, ArcId arc);
+        };
+
+        struct SearchState {
+            SearchSide forward;
+            SearchSide backward;
+        };
+
+        class Builder;
+
+        static SearchState& GetSearchState() {
+            static thread_local SearchState state;
+            return state;
+        }
+
+        static void Settle(const SearchGraph& search_graph, const SearchGraph& stall_graph, SearchSide& side,
+            const SearchSide& other, Weight& best_weight, VertexId& meeting_vertex);
+        void UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr Weight UNREACHED_WEIGHT = std::numeric_limits<Weight>::max();
+        static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+        static constexpr VertexId NO_VERTEX = std::numeric_limits<VertexId>::max();
+
+        size_t vertex_count_ = 0;
+        size_t edge_count_ = 0;
+        std::vector<Arc> arcs_;
+        SearchGraph upward_;
+        SearchGraph downward_;
+    };
+
+    /*
+     * Сжимает вершины по одной в порядке возрастания приоритета
+     * (разница рёбер + число уже сжатых соседей), пересчитывая приоритет лениво
+     */
+    template <typename Weight>
+    class ContractionHierarchy<Weight>::Builder {
+    public:
+        Builder(const Graph& graph, std::vector<Arc>& arcs)
+            : arcs_(arcs)
+            , out_arcs_(graph.GetVertexCount())
+            , in_arcs_(graph.GetVertexCount())
+            , contracted_neighbours_(graph.GetVertexCount(), 0)
+            , rank_(graph.GetVertexCount(), 0)
+            , witness_weights_(graph.GetVertexCount(), UNREACHED_WEIGHT)
+            , is_target_(graph.GetVertexCount(), false)
+        {
+            for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+                const VertexId from = graph.GetEdgeSource(edge_id);
+                const VertexId to = graph.GetEdgeTarget(edge_id);
+                arcs_.push_back({ from, to, graph.GetEdgeWeight(edge_id) });
+                if (from != to) {
+                    Link(edge_id);
+                }
+            }
+        }
+
+        std::vector<size_t> Contract() {
+            const size_t vertex_count = rank_.size();
+            std::vector<QueueItem> queue;
+            queue.reserve(vertex_count);
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                queue.push_back({ ComputePriority(vertex, FindShortcuts(vertex).size()), vertex });
+            }
+            std::make_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+
+            size_t next_rank = 0;
+            while (!queue.empty()) {
+                std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                const VertexId vertex = queue.back().vertex;
+                queue.pop_back();
+
+                const std::vector<Shortcut> shortcuts = FindShortcuts(vertex);
+                const long long priority = ComputePriority(vertex, shortcuts.size());
+                if (!queue.empty() && priority > queue.front().weight) {
+                    queue.push_back({ priority, vertex });
+                    std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                    continue;
+                }
+                ContractVertex(vertex, shortcuts);
+                rank_[vertex] = next_rank++;
+            }
+            return std::move(rank_);
+        }
+
+    private:
+        struct QueueItem {
+            long long weight;
+            VertexId vertex;
+
+            bool operator>(const QueueItem& other) const {
+                return weight > other.weight;
+            }
+        };
+
+        struct WitnessItem {
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const WitnessItem& other) const {
+                return weight > other.weight;
+            }
+        };
+
+        struct Shortcut {
+            ArcId first;
+            ArcId second;
+        };
+
+        // Поиск свидетелей прерывается после стольких вершин; недосчитанные
+        // пути считаются отсутствующими, что даёт лишние, но не ошибочные сокращения
+        static constexpr size_t WITNESS_SETTLE_LIMIT = 50;
+
+        // Списки смежности хранят не больше одной, самой лёгкой, дуги между парой вершин
+        void Link(ArcId arc_id) {
+            const Arc& arc = arcs_[arc_id];
+            std::vector<ArcId>& out_arcs = out_arcs_[arc.from];
+            const auto it = std::find_if(out_arcs.begin(), out_arcs.end(), [this, &arc](ArcId other) {
+                return arcs_[other].to == arc.to;
+                });
+            if (it == out_arcs.end()) {
+                out_arcs.push_back(arc_id);
+                in_arcs_[arc.to].push_back(arc_id);
+            }
+            else if (arc.weight < arcs_[*it].weight) {
+                std::vector<ArcId>& in_arcs = in_arcs_[arc.to];
+                *std::find(in_arcs.begin(), in_arcs.end(), *it) = arc_id;
+                *it = arc_id;
+            }
+        }
+
+        static void Unlink(std::vector<ArcId>& arcs, ArcId arc_id) {
+            arcs.erase(std::find(arcs.begin(), arcs.end(), arc_id));
+        }
+
+        // Находит сокращения, без которых при сжатии vertex удлинились бы пути
+        std::vector<Shortcut> FindShortcuts(VertexId vertex) {
+            const std::vector<ArcId>& in_arcs = in_arcs_[vertex];
+            const std::vector<ArcId>& out_arcs = out_arcs_[vertex];
+
+            std::vector<Shortcut> shortcuts;
+            if (out_arcs.empty()) {
+                return shortcuts;
+            }
+            for (const ArcId in_arc : in_arcs) {
+                const VertexId source = arcs_[in_arc].from;
+                Weight max_weight = ZERO_WEIGHT;
+                size_t target_count = 0;
+                for (const ArcId out_arc : out_arcs) {
+                    if (arcs_[out_arc].to != source) {
+                        max_weight = std::max(max_weight, arcs_[in_arc].weight + arcs_[out_arc].weight);
+                        is_target_[arcs_[out_arc].to] = true;
+                        ++target_count;
+                    }
+                }
+                RunWitnessSearch(in_arc, out_arcs, max_weight, target_count);
+                for (const ArcId out_arc : out_arcs) {
+                    const VertexId target = arcs_[out_arc].to;
+                    is_target_[target] = false;
+                    if (target != source
+                        && witness_weights_[target] > arcs_[in_arc].weight + arcs_[out_arc].weight) {
+                        shortcuts.push_back({ in_arc, out_arc });
+                    }
+                }
+            }
+            return shortcuts;
+        }
+
+        // Дейкстра из начала in_arc в обход сжимаемой вершины; останавливается, когда найдены все цели,
+        // пройден вес max_weight или исчерпан лимит вершин. Чаще всего свидетелями служат
+        // прямые дуги, поэтому после первого шага проверяется, не найдены ли уже все пути
+        void RunWitnessSearch(ArcId in_arc, const std::vector<ArcId>& out_arcs, Weight max_weight, size_t target_count) {
+            const VertexId source = arcs_[in_arc].from;
+            const VertexId excluded = arcs_[in_arc].to;
+            for (const VertexId vertex : witness_touched_) {
+                witness_weights_[vertex] = UNREACHED_WEIGHT;
+            }
+            witness_touched_.clear();
+            witness_queue_.clear();
+
+            witness_weights_[source] = ZERO_WEIGHT;
+            witness_touched_.push_back(source);
+            witness_queue_.push_back({ ZERO_WEIGHT, source });
+
+            size_t settled = 0;
+            while (!witness_queue_.empty() && settled < WITNESS_SETTLE_LIMIT && target_count > 0) {
+                std::pop_heap(witness_queue_.begin(), witness_queue_.end(), std::greater<WitnessItem>{});
+                const WitnessItem item = witness_queue_.back();
+                witness_queue_.pop_back();
+                if (item.weight > witness_weights_[item.vertex]) {
+                    continue;
+                }
+                if (item.weight > max_weight) {
+                    break;
+                }
+                ++settled;
+                if (is_target_[item.vertex]) {
+                    --target_count;
+                }
+                for (const ArcId arc_id : out_arcs_[item.vertex]) {
+                    const Arc& arc = arcs_[arc_id];
+                    if (arc.to == excluded) {
+                        continue;
+                    }
+                    const Weight candidate_weight = item.weight + arc.weight;
+                    Weight& weight_to = witness_weights_[arc.to];
+                    if (candidate_weight < weight_to) {
+                        if (weight_to == UNREACHED_WEIGHT) {
+                            witness_touched_.push_back(arc.to);
+                        }
+                        weight_to = candidate_weight;
+                        witness_queue_.push_back({ candidate_weight, arc.to });
+                        std::push_heap(witness_queue_.begin(), witness_queue_.end(), std::greater<WitnessItem>{});
+                    }
+                }
+                if (item.vertex == source && AllWitnessed(in_arc, out_arcs)) {
+                    break;
+                }
+            }
+        }
+
+        bool AllWitnessed(ArcId in_arc, const std::vector<ArcId>& out_arcs) const {
+            const Arc& first = arcs_[in_arc];
+            return std::all_of(out_arcs.begin(), out_arcs.end(), [this, &first](ArcId out_arc) {
+                const Arc& second = arcs_[out_arc];
+                return second.to == first.from || witness_weights_[second.to] <= first.weight + second.weight;
+                });
+        }
+
+        long long ComputePriority(VertexId vertex, size_t shortcut_count) const {
+            const size_t degree = in_arcs_[vertex].size() + out_arcs_[vertex].size();
+            return static_cast<long long>(shortcut_count) - static_cast<long long>(degree)
+                + contracted_neighbours_[vertex];
+        }
+
+        void ContractVertex(VertexId vertex, const std::vector<Shortcut>& shortcuts) {
+            for (const ArcId arc_id : in_arcs_[vertex]) {
+                const VertexId neighbour = arcs_[arc_id].from;
+                Unlink(out_arcs_[neighbour], arc_id);
+                ++contracted_neighbours_[neighbour];
+            }
+            for (const ArcId arc_id : out_arcs_[vertex]) {
+                const VertexId neighbour = arcs_[arc_id].to;
+                Unlink(in_arcs_[neighbour], arc_id);
+                ++contracted_neighbours_[neighbour];
+            }
+            out_arcs_[vertex] = {};
+            in_arcs_[vertex] = {};
+
+            for (const Shortcut& shortcut : shortcuts) {
+                const Arc& first = arcs_[shortcut.first];
+                const Arc& second = arcs_[shortcut.second];
+                const Arc shortcut_arc{ first.from, second.to, first.weight + second.weight, shortcut.first, shortcut.second };
+                arcs_.push_back(shortcut_arc);
+                Link(arcs_.size() - 1);
+            }
+        }
+
+        std::vector<Arc>& arcs_;
+        std::vector<std::vector<ArcId>> out_arcs_;
+        std::vector<std::vector<ArcId>> in_arcs_;
+        std::vector<long long> contracted_neighbours_;
+        std::vector<size_t> rank_;
+
+        std::vector<Weight> witness_weights_;
+        std::vector<VertexId> witness_touched_;
+        std::vector<WitnessItem> witness_queue_;
+        std::vector<bool> is_target_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+        : vertex_count_(graph.GetVertexCount())
+        , edge_count_(graph.GetEdgeCount())
+    {
+        arcs_.reserve(edge_count_);
+        const std::vector<size_t> rank = Builder(graph, arcs_).Contract();
+
+        // Каждая дуга попадает ровно в один из графов поиска:
+        // в прямой - у вершины-начала, если ведёт вверх по рангу,
+        // в обратный - у вершины-конца, если ведёт вниз
+        auto build_search_graph = [this, &rank](SearchGraph& search_graph, bool upward) {
+            search_graph.offsets.assign(vertex_count_ + 1, 0);
+            auto owner = [&](const Arc& arc) {
+                return upward ? arc.from : arc.to;
+            };
+            auto belongs = [&](const Arc& arc) {
+                return upward ? rank[arc.from] < rank[arc.to] : rank[arc.from] > rank[arc.to];
+            };
+            for (const Arc& arc : arcs_) {
+                if (belongs(arc)) {
+                    ++search_graph.offsets[owner(arc) + 1];
+                }
+            }
+            for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+                search_graph.offsets[vertex + 1] += search_graph.offsets[vertex];
+            }
+            const size_t arc_count = search_graph.offsets.back();
+            search_graph.targets.resize(arc_count);
+            search_graph.weights.resize(arc_count);
+            search_graph.arcs.resize(arc_count);
+
+            std::vector<size_t> positions(search_graph.offsets.begin(), search_graph.offsets.end() - 1);
+            for (ArcId arc_id = 0; arc_id < arcs_.size(); ++arc_id) {
+                const Arc& arc = arcs_[arc_id];
+                if (!belongs(arc)) {
+                    continue;
+                }
+                const size_t position = positions[owner(arc)]++;
+                search_graph.targets[position] = upward ? arc.to : arc.from;
+                search_graph.weights[position] = arc.weight;
+                search_graph.arcs[position] = arc_id;
+            }
+        };
+        build_search_graph(upward_, true);
+        build_search_graph(downward_, false);
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::SearchSide::Prepare(size_t vertex_count) {
+        for (const VertexId vertex : touched) {
+            weights[vertex] = UNREACHED_WEIGHT;
+            parent_arcs[vertex] = NO_ARC;
+        }
+        touched.clear();
+        queue.clear();
+        if (weights.size() < vertex_count) {
+            weights.resize(vertex_count, UNREACHED_WEIGHT);
+            parent_arcs.resize(vertex_count, NO_ARC);
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::SearchSide::Reach(VertexId vertex, Weight weight, ArcId arc) {
+        if (weights[vertex] == UNREACHED_WEIGHT) {
+            touched.push_back(vertex);
+        }
+        weights[vertex] = weight;
+        parent_arcs[vertex] = arc;
+        queue.push_back({ weight, vertex });
+        std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::Settle(const SearchGraph& search_graph, const SearchGraph& stall_graph,
+        SearchSide& side, const SearchSide& other, Weight& best_weight, VertexId& meeting_vertex) {
+        std::pop_heap(side.queue.begin(), side.queue.end(), std::greater<QueueItem>{});
+        const QueueItem item = side.queue.back();
+        side.queue.pop_back();
+        if (item.weight > side.weights[item.vertex]) {
+            return;
+        }
+
+        if (other.weights[item.vertex] != UNREACHED_WEIGHT) {
+            const Weight candidate_weight = item.weight + other.weights[item.vertex];
+            if (candidate_weight < best_weight) {
+                best_weight = candidate_weight;
+                meeting_vertex = item.vertex;
+            }
+        }
+
+        // Stall-on-demand: если в вершину можно дешевле прийти сверху,
+        // путь через неё не кратчайший и раскрывать её рёбра незачем
+        for (size_t i = stall_graph.offsets[item.vertex]; i < stall_graph.offsets[item.vertex + 1]; ++i) {
+            const Weight higher_weight = side.weights[stall_graph.targets[i]];
+            if (higher_weight != UNREACHED_WEIGHT && higher_weight + stall_graph.weights[i] < item.weight) {
+                return;
+            }
+        }
+
+        for (size_t i = search_graph.offsets[item.vertex]; i < search_graph.offsets[item.vertex + 1]; ++i) {
+            const Weight candidate_weight = item.weight + search_graph.weights[i];
+            if (candidate_weight < side.weights[search_graph.targets[i]]) {
+                side.Reach(search_graph.targets[i], candidate_weight, search_graph.arcs[i]);
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::Save(std::ostream& output) const {
+        serialization::WritePod<uint64_t>(output, vertex_count_);
+        serialization::WritePod<uint64_t>(output, edge_count_);
+        serialization::WriteVector(output, arcs_);
+        for (const SearchGraph* search_graph : { &upward_, &downward_ }) {
+            serialization::WriteVector(output, search_graph->offsets);
+            serialization::WriteVector(output, search_graph->targets);
+            serialization::WriteVector(output, search_graph->weights);
+            serialization::WriteVector(output, search_graph->arcs);
+        }
+    }
+
+    /*
+     * Поиск и раскрытие сокращений обращаются к массивам без проверок, поэтому при загрузке
+     * проверяется каждая дуга: концы - существующие вершины, части сокращения - дуги с меньшими
+     * номерами (так раскрытие не зациклится), а рёбра поиска совпадают со своими дугами
+     */
+    template <typename Weight>
+    ContractionHierarchy<Weight> ContractionHierarchy<Weight>::Load(const Graph& graph, std::istream& input) {
+        auto fail = [] {
+            throw serialization::FormatError("Inconsistent contraction hierarchy in snapshot");
+        };
+
+        ContractionHierarchy hierarchy;
+        hierarchy.vertex_count_ = serialization::ReadPod<uint64_t>(input);
+        hierarchy.edge_count_ = serialization::ReadPod<uint64_t>(input);
+        hierarchy.arcs_ = serialization::ReadVector<Arc>(input);
+        const size_t vertex_count = hierarchy.vertex_count_;
+        const auto& arcs = hierarchy.arcs_;
+        if (vertex_count != graph.GetVertexCount() || hierarchy.edge_count_ != graph.GetEdgeCount()
+            || hierarchy.edge_count_ > arcs.size()) {
+            fail();
+        }
+        for (ArcId arc_id = 0; arc_id < arcs.size(); ++arc_id) {
+            const Arc& arc = arcs[arc_id];
+            if (arc.from >= vertex_count || arc.to >= vertex_count || !(arc.weight >= ZERO_WEIGHT)) {
+                fail();
+            }
+            const bool is_shortcut = arc_id >= hierarchy.edge_count_;
+            if (is_shortcut ? arc.first >= arc_id || arc.second >= arc_id : arc.first != NO_ARC || arc.second != NO_ARC) {
+                fail();
+            }
+        }
+
+        for (SearchGraph* search_graph : { &hierarchy.upward_, &hierarchy.downward_ }) {
+            search_graph->offsets = serialization::ReadVector<size_t>(input);
+            search_graph->targets = serialization::ReadVector<VertexId>(input);
+            search_graph->weights = serialization::ReadVector<Weight>(input);
+            search_graph->arcs = serialization::ReadVector<ArcId>(input);
+
+            const bool upward = search_graph == &hierarchy.upward_;
+            const auto& offsets = search_graph->offsets;
+            const size_t arc_count = search_graph->targets.size();
+            if (offsets.size() != vertex_count + 1 || offsets.front() != 0 || offsets.back() != arc_count
+                || search_graph->weights.size() != arc_count || search_graph->arcs.size() != arc_count) {
+                fail();
+            }
+            if (!std::is_sorted(offsets.begin(), offsets.end())) {
+                fail();
+            }
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                    const ArcId arc_id = search_graph->arcs[i];
+                    if (arc_id >= arcs.size() || !(search_graph->weights[i] >= ZERO_WEIGHT)) {
+                        fail();
+                    }
+                    const Arc& arc = arcs[arc_id];
+                    const VertexId owner = upward ? arc.from : arc.to;
+                    const VertexId target = upward ? arc.to : arc.from;
+                    if (owner != vertex || target != search_graph->targets[i]) {
+                        fail();
+                    }
+                }
+            }
+        }
+        return hierarchy;
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchy<Weight>::Path> ContractionHierarchy<Weight>::FindPath(
+        VertexId from, VertexId to) const {
+        SearchState& state = GetSearchState();
+        SearchSide& forward = state.forward;
+        SearchSide& backward = state.backward;
+        forward.Prepare(vertex_count_);
+        backward.Prepare(vertex_count_);
+
+        forward.Reach(from, ZERO_WEIGHT, NO_ARC);
+        backward.Reach(to, ZERO_WEIGHT, NO_ARC);
+
+        Weight best_weight = UNREACHED_WEIGHT;
+        VertexId meeting_vertex = NO_VERTEX;
+        while (true) {
+            const bool forward_active = !forward.queue.empty() && forward.queue.front().weight < best_weight;
+            const bool backward_active = !backward.queue.empty() && backward.queue.front().weight < best_weight;
+            if (!forward_active && !backward_active) {
+                break;
+            }
+            if (forward_active && (!backward_active || forward.queue.front().weight <= backward.queue.front().weight)) {
+                Settle(upward_, downward_, forward, backward, best_weight, meeting_vertex);
+            }
+            else {
+                Settle(downward_, upward_, backward, forward, best_weight, meeting_vertex);
+            }
+        }
+
+        if (meeting_vertex == NO_VERTEX) {
+            return std::nullopt;
+        }
+
+        std::vector<ArcId> forward_arcs;
+        for (VertexId vertex = meeting_vertex; forward.parent_arcs[vertex] != NO_ARC; vertex = arcs_[forward.parent_arcs[vertex]].from) {
+            forward_arcs.push_back(forward.parent_arcs[vertex]);
+        }
+
+        std::vector<EdgeId> edges;
+        for (auto it = forward_arcs.rbegin(); it != forward_arcs.rend(); ++it) {
+            UnpackArc(*it, edges);
+        }
+        for (VertexId vertex = meeting_vertex; backward.parent_arcs[vertex] != NO_ARC; vertex = arcs_[backward.parent_arcs[vertex]].to) {
+            UnpackArc(backward.parent_arcs[vertex], edges);
+        }
+
+        return Path{ best_weight, std::move(edges) };
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const {
+        std::vector<ArcId> stack{ arc_id };
+        while (!stack.empty()) {
+            const ArcId current = stack.back();
+            stack.pop_back();
+            if (current < edge_count_) {
+                edges.push_back(current);
+            }
+            else {
+                stack.push_back(arcs_[current].second);
+                stack.push_back(arcs_[current].first);
+            }
+        }
+    }
+
+}  // namespace graph
@@ -0,0 +1,78 @@
+// distance_table.cpp
+
+#include "distance_table.h"
+
+#include <bit>
+#include <stdexcept>
+
+namespace transport {
+    namespace catalogue {
+
+        namespace {
+            constexpr uint64_t FIBONACCI_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+            constexpr size_t MIN_CAPACITY = 16;
+        }
+
+        void DistanceTable::Set(uint32_t from, uint32_t to, int distance) {
+            if (!Insert(from, to, distance)) {
+                entries_[FindSlot(MakeKey(from, to))].distance = distance;
+            }
+        }
+
+        bool DistanceTable::Insert(uint32_t from, uint32_t to, int distance) {
+            if ((size_ + 1) * 4 > entries_.size() * 3) {
+                Grow();
+            }
+            const uint64_t key = MakeKey(from, to);
+            Entry& entry = entries_[FindSlot(key)];
+            if (entry.key == key) {
+                return false;
+            }
+            entry = { key, distance };
+            ++size_;
+            return true;
+        }
+
+        std::optional<int> DistanceTable::Find(uint32_t from, uint32_t to) const {
+            if (entries_.empty()) {
+                return std::nullopt;
+            }
+            const uint64_t key = MakeKey(from, to);
+            const Entry& entry = entries_[FindSlot(key)];
+            if (entry.key != key) {
+                return std::nullopt;
+            }
+            return entry.distance;
+        }
+
+        int DistanceTable::At(uint32_t from, uint32_t to) const {
+            if (const auto distance = Find(from, to)) {
+                return *distance;
+            }
+            throw std::out_of_range("Distance between stops is not set");
+        }
+
+        // Ячейка с таким ключом либо первая пустая на пути к ней
+        size_t DistanceTable::FindSlot(uint64_t key) const {
+            const size_t mask = entries_.size() - 1;
+            size_t slot = static_cast<size_t>((key * FIBONACCI_MULTIPLIER) >> shift_);
+            while (entries_[slot].key != key && entries_[slot].key != EMPTY_KEY) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        void DistanceTable::Grow() {
+            const size_t capacity = entries_.empty() ? MIN_CAPACITY : entries_.size() * 2;
+            std::vector<Entry> old_entries(capacity, Entry{ EMPTY_KEY, 0 });
+            old_entries.swap(entries_);
+            shift_ = 64 - std::countr_zero(capacity);
+            for (const Entry& entry : old_entries) {
+                if (entry.key != EMPTY_KEY) {
+                    entries_[FindSlot(entry.key)] = entry;
+                }
+            }
+        }
+
+    } // namespace catalogue
+} // namespace transport
@@ -0,0 +1,68 @@
+// distance_table.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace transport {
+    namespace catalogue {
+
+        /*
+         * Расстояния по дорогам между парами остановок, заданными номерами. Пара упаковывается
+         * в 64-битный ключ (from << 32 | to), записи лежат в одном массиве с открытой адресацией
+         * и линейным пробированием. Номер ячейки - старшие биты ключа, умноженного на константу
+         * Фибоначчи, поэтому соседние номера остановок не попадают в соседние ячейки.
+         * Массив удваивается, когда заполнен на 3/4
+         */
+        class DistanceTable {
+        public:
+            // Задаёт расстояние, заменяя прежнее
+            void Set(uint32_t from, uint32_t to, int distance);
+            // Добавляет расстояние, только если для пары его ещё нет; возвращает true, если добавило
+            bool Insert(uint32_t from, uint32_t to, int distance);
+
+            std::optional<int> Find(uint32_t from, uint32_t to) const;
+            // Бросает std::out_of_range, если расстояние не задано
+            int At(uint32_t from, uint32_t to) const;
+
+            size_t Size() const {
+                return size_;
+            }
+
+            // Вызывает callback(from, to, distance) для каждой пары в порядке ячеек
+            template <typename Callback>
+            void ForEach(Callback callback) const {
+                for (const Entry& entry : entries_) {
+                    if (entry.key != EMPTY_KEY) {
+                        callback(static_cast<uint32_t>(entry.key >> 32), static_cast<uint32_t>(entry.key), entry.distance);
+                    }
+                }
+            }
+
+        private:
+            struct Entry {
+                uint64_t key;
+                int distance;
+            };
+
+            // Пара (UINT32_MAX, UINT32_MAX) как остановка не встречается
+            static constexpr uint64_t EMPTY_KEY = ~uint64_t{ 0 };
+
+            static uint64_t MakeKey(uint32_t from, uint32_t to) {
+                return uint64_t{ from } << 32 | to;
+            }
+
+            size_t FindSlot(uint64_t key) const;
+            void Grow();
+
+            std::vector<Entry> entries_;
+            size_t size_ = 0;
+            // 64 минус log2 числа ячеек
+            int shift_ = 64;
+        };
+
+    } // namespace catalogue
+} // namespace transport
@@ -0,0 +1,209 @@
+// geo.cpp
+
+#include "geo.h"
+
+#include <numeric>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GEO_SIMD_X86 1
+#define GEO_SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#define GEO_SIMD_X86 1
+#define GEO_SIMD_TARGET(isa)
+#endif
+
+namespace transport {
+    namespace geo {
+
+        namespace {
+
+            // Отрезки начиная с first-го
+            void ComputeSegmentLengthsScalar(const UnitPath& path, double* lengths, size_t first) {
+                for (size_t i = first + 1; i < path.Size(); ++i) {
+                    lengths[i - 1] = ComputeDistance(UnitVector{ path.x[i - 1], path.y[i - 1], path.z[i - 1] },
+                        UnitVector{ path.x[i], path.y[i], path.z[i] });
+                }
+            }
+
+#if defined(GEO_SIMD_X86)
+            /*
+             * arcsin из библиотеки Cephes. При a <= 0.625 asin(a) = a + a * w * P(w) / Q(w), где w = a * a,
+             * иначе asin(a) = pi/2 - sqrt(2w) * (1 + w * R(w) / S(w)), где w = 1 - a. Чтобы обойтись
+             * одним делением, коэффициенты обеих ветвей дополнены нулями до одной длины и выбираются
+             * по маске, а результат ветвей - в самом конце. Отрезки короче 8000 км всегда попадают
+             * в первую ветвь, и блок, где других нет, считается без выбора
+             */
+            constexpr int ASIN_COEFF_COUNT = 6;
+            constexpr double ASIN_SMALL_NUM[ASIN_COEFF_COUNT] = {
+                4.253011369004428248960E-3, -6.019598008014123785661E-1, 5.444622390564711410273E0,
+                -1.626247967210700244449E1, 1.956261983317594739197E1, -8.198089802484824371615E0,
+            };
+            constexpr double ASIN_SMALL_DEN[ASIN_COEFF_COUNT] = {
+                1.0, -1.474091372988853791896E1, 7.049610280856842141659E1,
+                -1.471791292232726029859E2, 1.395105614657485689735E2, -4.918853881490881290097E1,
+            };
+            constexpr double ASIN_LARGE_NUM[ASIN_COEFF_COUNT] = {
+                0.0, 2.967721961301243206100E-3, -5.634242780008963776856E-1,
+                6.968710824104713396794E0, -2.556901049652824852289E1, 2.853665548261061424989E1,
+            };
+            constexpr double ASIN_LARGE_DEN[ASIN_COEFF_COUNT] = {
+                0.0, 1.0, -2.194779531642920639778E1,
+                1.470656354026814941758E2, -3.838770957603691357202E2, 3.424398657913078477438E2,
+            };
+            constexpr double ASIN_BRANCH = 0.625;
+            constexpr double PI_4 = 7.85398163397448309616E-1;
+            constexpr double PI_2_LOW_BITS = 6.123233995736765886130E-17;
+
+            GEO_SIMD_TARGET("sse2")
+            __m128d Select(__m128d mask, __m128d if_true, __m128d if_false) {
+                return _mm_or_pd(_mm_and_pd(mask, if_true), _mm_andnot_pd(mask, if_false));
+            }
+
+            // a в [0, 1]
+            GEO_SIMD_TARGET("sse2")
+            __m128d Asin(__m128d a) {
+                const __m128d large = _mm_cmpgt_pd(a, _mm_set1_pd(ASIN_BRANCH));
+                if (_mm_movemask_pd(large) == 0) {
+                    const __m128d w = _mm_mul_pd(a, a);
+                    __m128d num = _mm_setzero_pd();
+                    __m128d den = _mm_setzero_pd();
+                    for (int i = 0; i < ASIN_COEFF_COUNT; ++i) {
+                        num = _mm_add_pd(_mm_mul_pd(num, w), _mm_set1_pd(ASIN_SMALL_NUM[i]));
+                        den = _mm_add_pd(_mm_mul_pd(den, w), _mm_set1_pd(ASIN_SMALL_DEN[i]));
+                    }
+                    return _mm_add_pd(_mm_mul_pd(a, _mm_div_pd(_mm_mul_pd(w, num), den)), a);
+                }
+                const __m128d w = Select(large, _mm_sub_pd(_mm_set1_pd(1.0), a), _mm_mul_pd(a, a));
+                __m128d num = _mm_setzero_pd();
+                __m128d den = _mm_setzero_pd();
+                for (int i = 0; i < ASIN_COEFF_COUNT; ++i) {
+                    num = _mm_add_pd(_mm_mul_pd(num, w),
+                        Select(large, _mm_set1_pd(ASIN_LARGE_NUM[i]), _mm_set1_pd(ASIN_SMALL_NUM[i])));
+                    den = _mm_add_pd(_mm_mul_pd(den, w),
+                        Select(large, _mm_set1_pd(ASIN_LARGE_DEN[i]), _mm_set1_pd(ASIN_SMALL_DEN[i])));
+                }
+                const __m128d ratio = _mm_div_pd(_mm_mul_pd(w, num), den);
+
+                const __m128d small_result = _mm_add_pd(_mm_mul_pd(a, ratio), a);
+                const __m128d root = _mm_sqrt_pd(_mm_add_pd(w, w));
+                const __m128d large_result = _mm_add_pd(
+                    _mm_sub_pd(_mm_sub_pd(_mm_set1_pd(PI_4), root),
+                        _mm_sub_pd(_mm_mul_pd(root, ratio), _mm_set1_pd(PI_2_LOW_BITS))),
+                    _mm_set1_pd(PI_4));
+                return Select(large, large_result, small_result);
+            }
+
+            GEO_SIMD_TARGET("avx2")
+            __m256d Asin(__m256d a) {
+                const __m256d large = _mm256_cmp_pd(a, _mm256_set1_pd(ASIN_BRANCH), _CMP_GT_OQ);
+                if (_mm256_movemask_pd(large) == 0) {
+                    const __m256d w = _mm256_mul_pd(a, a);
+                    __m256d num = _mm256_setzero_pd();
+                    __m256d den = _mm256_setzero_pd();
+                    for (int i = 0; i < ASIN_COEFF_COUNT; ++i) {
+                        num = _mm256_add_pd(_mm256_mul_pd(num, w), _mm256_set1_pd(ASIN_SMALL_NUM[i]));
+                        den = _mm256_add_pd(_mm256_mul_pd(den, w), _mm256_set1_pd(ASIN_SMALL_DEN[i]));
+                    }
+                    return _mm256_add_pd(_mm256_mul_pd(a, _mm256_div_pd(_mm256_mul_pd(w, num), den)), a);
+                }
+                const __m256d w = _mm256_blendv_pd(_mm256_mul_pd(a, a), _mm256_sub_pd(_mm256_set1_pd(1.0), a), large);
+                __m256d num = _mm256_setzero_pd();
+                __m256d den = _mm256_setzero_pd();
+                for (int i = 0; i < ASIN_COEFF_COUNT; ++i) {
+                    num = _mm256_add_pd(_mm256_mul_pd(num, w),
+                        _mm256_blendv_pd(_mm256_set1_pd(ASIN_SMALL_NUM[i]), _mm256_set1_pd(ASIN_LARGE_NUM[i]), large));
+                    den = _mm256_add_pd(_mm256_mul_pd(den, w),
+                        _mm256_blendv_pd(_mm256_set1_pd(ASIN_SMALL_DEN[i]), _mm256_set1_pd(ASIN_LARGE_DEN[i]), large));
+                }
+                const __m256d ratio = _mm256_div_pd(_mm256_mul_pd(w, num), den);
+
+                const __m256d small_result = _mm256_add_pd(_mm256_mul_pd(a, ratio), a);
+                const __m256d root = _mm256_sqrt_pd(_mm256_add_pd(w, w));
+                const __m256d large_result = _mm256_add_pd(
+                    _mm256_sub_pd(_mm256_sub_pd(_mm256_set1_pd(PI_4), root),
+                        _mm256_sub_pd(_mm256_mul_pd(root, ratio), _mm256_set1_pd(PI_2_LOW_BITS))),
+                    _mm256_set1_pd(PI_4));
+                return _mm256_blendv_pd(small_result, large_result, large);
+            }
+
+            // Отрезки с i по i + 1 берутся из соседних невыровненных загрузок одних и тех же массивов
+            GEO_SIMD_TARGET("sse2")
+            void ComputeSegmentLengthsSse2(const UnitPath& path, double* lengths) {
+                const double* x = path.x.data();
+                const double* y = path.y.data();
+                const double* z = path.z.data();
+                const size_t size = path.Size();
+                size_t i = 0;
+                for (; i + 2 < size; i += 2) {
+                    const __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(x + i + 1));
+                    const __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(y + i + 1));
+                    const __m128d dz = _mm_sub_pd(_mm_loadu_pd(z + i), _mm_loadu_pd(z + i + 1));
+                    const __m128d chord = _mm_sqrt_pd(
+                        _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz)));
+                    const __m128d half_chord = _mm_min_pd(_mm_mul_pd(chord, _mm_set1_pd(0.5)), _mm_set1_pd(1.0));
+                    _mm_storeu_pd(lengths + i, _mm_mul_pd(Asin(half_chord), _mm_set1_pd(2 * EARTH_RADIUS)));
+                }
+                ComputeSegmentLengthsScalar(path, lengths, i);
+            }
+
+            GEO_SIMD_TARGET("avx2")
+            void ComputeSegmentLengthsAvx2(const UnitPath& path, double* lengths) {
+                const double* x = path.x.data();
+                const double* y = path.y.data();
+                const double* z = path.z.data();
+                const size_t size = path.Size();
+                size_t i = 0;
+                for (; i + 4 < size; i += 4) {
+                    const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(x + i + 1));
+                    const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(y + i + 1));
+                    const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + i), _mm256_loadu_pd(z + i + 1));
+                    const __m256d chord = _mm256_sqrt_pd(_mm256_add_pd(
+                        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz)));
+                    const __m256d half_chord = _mm256_min_pd(_mm256_mul_pd(chord, _mm256_set1_pd(0.5)), _mm256_set1_pd(1.0));
+                    _mm256_storeu_pd(lengths + i, _mm256_mul_pd(Asin(half_chord), _mm256_set1_pd(2 * EARTH_RADIUS)));
+                }
+                ComputeSegmentLengthsScalar(path, lengths, i);
+            }
+#endif
+
+        }  // namespace
+
+        SimdLevel GetBestSimdLevel() {
+#if defined(__GNUC__) && defined(GEO_SIMD_X86)
+            static const SimdLevel level = __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE2;
+            return level;
+#elif defined(GEO_SIMD_X86)
+            return SimdLevel::SSE2;
+#else
+            return SimdLevel::SCALAR;
+#endif
+        }
+
+        void ComputeSegmentLengths(const UnitPath& path, double* lengths, SimdLevel level) {
+#if defined(GEO_SIMD_X86)
+            if (level == SimdLevel::AVX2 && GetBestSimdLevel() == SimdLevel::AVX2) {
+                ComputeSegmentLengthsAvx2(path, lengths);
+                return;
+            }
+            if (level != SimdLevel::SCALAR) {
+                ComputeSegmentLengthsSse2(path, lengths);
+                return;
+            }
+#endif
+            (void)level;
+            ComputeSegmentLengthsScalar(path, lengths, 0);
+        }
+
+        double ComputeLength(const UnitPath& path, SimdLevel level) {
+            if (path.Size() < 2) {
+                return 0;
+            }
+            std::vector<double> lengths(path.Size() - 1);
+            ComputeSegmentLengths(path, lengths.data(), level);
+            return std::accumulate(lengths.begin(), lengths.end(), 0.0);
+        }
+
+    } // namespace geo
+} // namespace transport
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 namespace transport {
     namespace geo {
@@ -16,6 +18,8 @@ namespace transport {
             }
         };
 
+        inline constexpr double EARTH_RADIUS = 6371000;
+
         inline double ComputeDistance(Coordinates from, Coordinates to) {
             using namespace std;
             if (from == to) {
@@ -24,10 +28,85 @@ namespace transport {
             static const double dr = 3.1415926535 / 180.;
             return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-                * 6371000;
+                * EARTH_RADIUS;
+        }
+
+        // Точка на сфере единичного радиуса
+        struct UnitVector {
+            double x = 0;
+            double y = 0;
+            double z = 0;
+        };
+
+        // Градусы переводятся в радианы с тем же приближением pi, что и в ComputeDistance
+        inline UnitVector ToUnitVector(Coordinates point) {
+            static const double dr = 3.1415926535 / 180.;
+            const double cos_lat = std::cos(point.lat * dr);
+            return { cos_lat * std::cos(point.lng * dr), cos_lat * std::sin(point.lng * dr), std::sin(point.lat * dr) };
         }
 
+        /*
+         * Длина дуги через хорду: 2 * asin(|from - to| / 2), без тригонометрии по координатам.
+         * acos в ComputeDistance на коротких отрезках теряет половину знаков, поэтому результаты
+         * расходятся примерно на 2e-9 / angle метров, где angle - угол отрезка в радианах:
+         * около 0.01 мм для отрезка в километр и около миллиметра для отрезка в 10 м
+         */
+        inline double ComputeDistance(const UnitVector& from, const UnitVector& to) {
+            const double dx = from.x - to.x;
+            const double dy = from.y - to.y;
+            const double dz = from.z - to.z;
+            const double half_chord = std::sqrt(dx * dx + dy * dy + dz * dz) * 0.5;
+            return 2 * std::asin(std::fmin(half_chord, 1.0)) * EARTH_RADIUS;
+        }
+
+        // Набор инструкций, которым считается длина ломаной
+        enum class SimdLevel {
+            SCALAR,
+            SSE2,
+            AVX2,
+        };
+
+        // Лучший уровень, поддерживаемый процессором, на котором запущена программа
+        SimdLevel GetBestSimdLevel();
+
+        // Вершины ломаной, разложенные по координатам, чтобы читать их блоками
+        struct UnitPath {
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> z;
+
+            void Reserve(size_t size) {
+                x.reserve(size);
+                y.reserve(size);
+                z.reserve(size);
+            }
+
+            void Add(const UnitVector& point) {
+                x.push_back(point.x);
+                y.push_back(point.y);
+                z.push_back(point.z);
+            }
+
+            void Clear() {
+                x.clear();
+                y.clear();
+                z.clear();
+            }
+
+            size_t Size() const {
+                return x.size();
+            }
+        };
+
+        /*
+         * Длины отрезков ломаной в метрах, как ComputeDistance по соседним вершинам: lengths[i] -
+         * от i-й вершины до (i + 1)-й; в lengths должно быть место для path.Size() - 1 значений. Отрезки обрабатываются по 4 (AVX2) или 2 (SSE2) сразу,
+         * arcsin считается полиномом Cephes с погрешностью в 1-2 ulp. Уровень выше
+         * поддерживаемого процессором понижается
+         */
+        void ComputeSegmentLengths(const UnitPath& path, double* lengths, SimdLevel level = GetBestSimdLevel());
+        // Длина всей ломаной
+        double ComputeLength(const UnitPath& path, SimdLevel level = GetBestSimdLevel());
 
     } // namespace geo
 } // namespace transport
-
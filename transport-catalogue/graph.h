@@ -1,10 +1,19 @@
 // graph.h
- 
+
 #pragma once
 
 #include "ranges.h"
+#include "serialization.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace graph {
@@ -21,58 +30,197 @@ namespace graph {
         Weight weight;
     };
 
+    /*
+     * Граф строится в два этапа. Сначала рёбра добавляются через AddEdge,
+     * затем Freeze() переводит граф в компактный формат CSR: рёбра группируются
+     * по начальной вершине, а их поля хранятся в отдельных непрерывных массивах.
+     * Обход рёбер вершины (GetIncidentEdges) доступен только после Freeze()
+     */
     template <typename Weight>
     class DirectedWeightedGraph {
     private:
-        using IncidenceList = std::vector<EdgeId>;
-        using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+        using IncidentEdgesRange = ranges::Range<ranges::IndexIterator<EdgeId>>;
+        using BusId = uint32_t;
 
     public:
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
         EdgeId AddEdge(const Edge<Weight>& edge);
 
+        // Переупорядочивает рёбра по начальной вершине (с сохранением порядка добавления),
+        // поэтому номера, которые вернул AddEdge, после вызова недействительны
+        void Freeze();
+        bool IsFrozen() const;
+
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
-        const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+        Edge<Weight> GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+        // Сохраняет замороженный граф. Названия автобусов записываются строками,
+        // а при загрузке resolve_bus возвращает для них строки с подходящим временем жизни
+        void Save(std::ostream& output) const;
+        static DirectedWeightedGraph Load(std::istream& input, const std::function<BusName(const std::string&)>& resolve_bus);
+
+        // Быстрый доступ к полям ребра замороженного графа
+        VertexId GetEdgeSource(EdgeId edge_id) const {
+            return sources_[edge_id];
+        }
+        VertexId GetEdgeTarget(EdgeId edge_id) const {
+            return targets_[edge_id];
+        }
+        Weight GetEdgeWeight(EdgeId edge_id) const {
+            return weights_[edge_id];
+        }
+
     private:
-        std::vector<Edge<Weight>> edges_;
-        std::vector<IncidenceList> incidence_lists_;
+        size_t vertex_count_ = 0;
+        std::vector<Edge<Weight>> pending_edges_;
+
+        std::vector<size_t> offsets_;
+        std::vector<VertexId> sources_;
+        std::vector<VertexId> targets_;
+        std::vector<Weight> weights_;
+        std::vector<BusId> bus_ids_;
+        std::vector<BusName> bus_names_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count) {
+        : vertex_count_(vertex_count) {
     }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
-        edges_.push_back(edge);
-        const EdgeId id = edges_.size() - 1;
-        incidence_lists_.at(edge.from).push_back(id);
-        return id;
+        if (IsFrozen()) {
+            throw std::logic_error("Can't add an edge to a frozen graph");
+        }
+        if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        pending_edges_.push_back(edge);
+        return pending_edges_.size() - 1;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (IsFrozen()) {
+            return;
+        }
+        const size_t edge_count = pending_edges_.size();
+
+        offsets_.assign(vertex_count_ + 1, 0);
+        for (const auto& edge : pending_edges_) {
+            ++offsets_[edge.from + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            offsets_[vertex + 1] += offsets_[vertex];
+        }
+
+        sources_.resize(edge_count);
+        targets_.resize(edge_count);
+        weights_.resize(edge_count);
+        bus_ids_.resize(edge_count);
+
+        std::unordered_map<BusName, BusId> bus_to_id;
+        std::vector<size_t> positions(offsets_.begin(), offsets_.end() - 1);
+        for (const auto& edge : pending_edges_) {
+            const auto [it, inserted] = bus_to_id.emplace(edge.bus, static_cast<BusId>(bus_names_.size()));
+            if (inserted) {
+                bus_names_.push_back(edge.bus);
+            }
+            const EdgeId id = positions[edge.from]++;
+            sources_[id] = edge.from;
+            targets_[id] = edge.to;
+            weights_[id] = edge.weight;
+            bus_ids_[id] = it->second;
+        }
+
+        pending_edges_.clear();
+        pending_edges_.shrink_to_fit();
+    }
+
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return !offsets_.empty();
     }
 
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return vertex_count_;
     }
 
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-        return edges_.size();
+        return IsFrozen() ? targets_.size() : pending_edges_.size();
     }
 
     template <typename Weight>
-    const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-        return edges_.at(edge_id);
+    Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+        if (!IsFrozen()) {
+            return pending_edges_.at(edge_id);
+        }
+        return { bus_names_[bus_ids_.at(edge_id)], sources_[edge_id], targets_[edge_id], weights_[edge_id] };
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Save(std::ostream& output) const {
+        if (!IsFrozen()) {
+            throw std::logic_error("Only a frozen graph can be saved");
+        }
+        serialization::WritePod<uint64_t>(output, vertex_count_);
+        serialization::WriteVector(output, offsets_);
+        serialization::WriteVector(output, sources_);
+        serialization::WriteVector(output, targets_);
+        serialization::WriteVector(output, weights_);
+        serialization::WriteVector(output, bus_ids_);
+        serialization::WritePod<uint64_t>(output, bus_names_.size());
+        for (const BusName bus_name : bus_names_) {
+            serialization::WriteString(output, std::string(bus_name));
+        }
+    }
+
+    template <typename Weight>
+    DirectedWeightedGraph<Weight> DirectedWeightedGraph<Weight>::Load(std::istream& input,
+        const std::function<BusName(const std::string&)>& resolve_bus) {
+        DirectedWeightedGraph graph(serialization::ReadPod<uint64_t>(input));
+        graph.offsets_ = serialization::ReadVector<size_t>(input);
+        graph.sources_ = serialization::ReadVector<VertexId>(input);
+        graph.targets_ = serialization::ReadVector<VertexId>(input);
+        graph.weights_ = serialization::ReadVector<Weight>(input);
+        graph.bus_ids_ = serialization::ReadVector<BusId>(input);
+        const auto bus_count = serialization::ReadPod<uint64_t>(input);
+        graph.bus_names_.reserve(bus_count);
+        for (uint64_t i = 0; i < bus_count; ++i) {
+            graph.bus_names_.push_back(resolve_bus(serialization::ReadString(input)));
+        }
+
+        // Дальше номера из массивов используются как индексы без проверок, поэтому проверяется каждый
+        const size_t edge_count = graph.targets_.size();
+        if (graph.offsets_.size() != graph.vertex_count_ + 1 || graph.offsets_.front() != 0 || graph.offsets_.back() != edge_count
+            || graph.sources_.size() != edge_count || graph.weights_.size() != edge_count || graph.bus_ids_.size() != edge_count) {
+            throw serialization::FormatError("Inconsistent graph in snapshot");
+        }
+        if (!std::is_sorted(graph.offsets_.begin(), graph.offsets_.end())) {
+            throw serialization::FormatError("Inconsistent graph in snapshot");
+        }
+        for (VertexId vertex = 0; vertex < graph.vertex_count_; ++vertex) {
+            for (EdgeId edge_id = graph.offsets_[vertex]; edge_id < graph.offsets_[vertex + 1]; ++edge_id) {
+                if (graph.sources_[edge_id] != vertex || graph.targets_[edge_id] >= graph.vertex_count_
+                    || graph.bus_ids_[edge_id] >= graph.bus_names_.size() || !(graph.weights_[edge_id] >= Weight{})) {
+                    throw serialization::FormatError("Inconsistent graph in snapshot");
+                }
+            }
+        }
+        return graph;
     }
 
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        if (!IsFrozen()) {
+            throw std::logic_error("Graph must be frozen before traversal");
+        }
+        return ranges::AsIndexRange(offsets_.at(vertex), offsets_.at(vertex + 1));
     }
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
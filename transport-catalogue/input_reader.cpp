@@ -132,9 +132,8 @@ namespace transport {
                 }
                 else if (command.command == "Bus") {
                     auto stops = detail::ParseRoute(command.description);
-                    std::vector<std::string> stop_names(stops.begin(), stops.end());
                     bool is_circular = command.description.find('>') != command.description.npos;
-                    catalogue.AddBus(command.id, stop_names, is_circular);
+                    catalogue.AddBus(command.id, stops, is_circular);
                 }
             }
         }
@@ -1,367 +1,635 @@
 #include "json.h"
+#include "json_scan.h"
+#include "number_format.h"
+#include "profiler.h"
 
+#include <charconv>
 #include <iterator>
+#include <string_view>
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
+        /*
+         * Разбор документа, целиком лежащего в памяти. Парсер идёт указателем по буферу,
+         * а числа преобразует через std::from_chars без промежуточных строк.
+         * Пробелы и содержимое строк просматриваются блоками по 16-32 байта (см. json_scan.h).
+         * Вместо построения дерева парсер сообщает о каждом элементе обработчику
+         */
+        class Parser {
+        public:
+            Parser(std::string_view input, Handler& handler)
+                : cur_(input.data())
+                , end_(input.data() + input.size())
+                , scanner_(GetScanner())
+                , handler_(handler) {
+            }
 
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
+            void ParseNode() {
+                char c;
+                if (!NextChar(c)) {
+                    throw ParsingError("Unexpected EOF"s);
+                }
+                switch (c) {
+                case '[':
+                    ParseArray();
+                    break;
+                case '{':
+                    ParseDict();
+                    break;
+                case '"':
+                    handler_.String(ParseString());
+                    break;
+                case 't':
+                    // встретив t или f, пробуем разобрать литерал true либо false
+                    [[fallthrough]];
+                case 'f':
+                    --cur_;
+                    ParseBool();
+                    break;
+                case 'n':
+                    --cur_;
+                    ParseNull();
+                    break;
+                default:
+                    --cur_;
+                    ParseNumber();
+                    break;
+                }
             }
-            return s;
-        }
 
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
+        private:
+            static bool IsSpace(char c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+            }
+
+            static bool IsDigit(char c) {
+                return c >= '0' && c <= '9';
+            }
 
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
+            static bool IsAlpha(char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            }
+
+            // Аналог input >> c: пропускает пробельные символы и читает следующий
+            bool NextChar(char& c) {
+                // Чаще всего пробел между лексемами один, и его дешевле пропустить на месте
+                if (cur_ != end_ && IsSpace(*cur_)) {
+                    ++cur_;
+                    if (cur_ != end_ && IsSpace(*cur_)) {
+                        cur_ = SkipSpaces(cur_, end_, scanner_);
+                    }
+                }
+                if (cur_ == end_) {
+                    return false;
                 }
-                result.push_back(LoadNode(input));
+                c = *cur_++;
+                return true;
             }
-            if (!input) {
-                throw ParsingError("Array parsing error"s);
+
+            std::string_view ParseLiteral() {
+                const char* begin = cur_;
+                while (cur_ != end_ && IsAlpha(*cur_)) {
+                    ++cur_;
+                }
+                return { begin, static_cast<size_t>(cur_ - begin) };
             }
-            return Node(std::move(result));
-        }
 
-        Node LoadDict(std::istream& input) {
-            Dict dict;
+            void ParseArray() {
+                handler_.StartArray();
 
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        dict.emplace(std::move(key), LoadNode(input));
+                char c;
+                bool closed = false;
+                while (NextChar(c)) {
+                    if (c == ']') {
+                        closed = true;
+                        break;
                     }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                    if (c != ',') {
+                        --cur_;
                     }
+                    ParseNode();
                 }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                if (!closed) {
+                    throw ParsingError("Array parsing error"s);
                 }
+                handler_.EndArray();
             }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
-            }
-            return Node(std::move(dict));
-        }
 
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true) {
-                if (it == end) {
-                    throw ParsingError("String parsing error");
+            void ParseDict() {
+                handler_.StartDict();
+
+                char c;
+                bool closed = false;
+                while (NextChar(c)) {
+                    if (c == '}') {
+                        closed = true;
+                        break;
+                    }
+                    if (c == '"') {
+                        const std::string_view key = ParseString();
+                        if (NextChar(c) && c == ':') {
+                            handler_.Key(key);
+                            ParseNode();
+                        }
+                        else {
+                            throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                        }
+                    }
+                    else if (c != ',') {
+                        throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                    }
                 }
-                const char ch = *it;
-                if (ch == '"') {
-                    ++it;
-                    break;
+                if (!closed) {
+                    throw ParsingError("Dictionary parsing error"s);
                 }
-                else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
+                handler_.EndDict();
+            }
+
+            // Строка без экранирования возвращается как участок входного буфера,
+            // иначе собирается в scratch_. Результат действителен до следующего вызова
+            std::string_view ParseString() {
+                const char* run_begin = cur_;
+                cur_ = FindStringStop(cur_, end_, scanner_);
+                if (cur_ != end_ && *cur_ == '"') {
+                    return { run_begin, static_cast<size_t>(cur_++ - run_begin) };
+                }
+
+                scratch_.assign(run_begin, cur_);
+                while (true) {
+                    if (cur_ == end_) {
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
-                    switch (escaped_char) {
-                    case 'n':
-                        s.push_back('\n');
+                    const char ch = *cur_++;
+                    if (ch == '"') {
                         break;
-                    case 't':
-                        s.push_back('\t');
-                        break;
-                    case 'r':
-                        s.push_back('\r');
-                        break;
-                    case '"':
-                        s.push_back('"');
-                        break;
-                    case '\\':
-                        s.push_back('\\');
-                        break;
-                    default:
-                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
                     }
+                    else if (ch == '\\') {
+                        if (cur_ == end_) {
+                            throw ParsingError("String parsing error");
+                        }
+                        const char escaped_char = *cur_++;
+                        switch (escaped_char) {
+                        case 'n':
+                            scratch_.push_back('\n');
+                            break;
+                        case 't':
+                            scratch_.push_back('\t');
+                            break;
+                        case 'r':
+                            scratch_.push_back('\r');
+                            break;
+                        case '"':
+                            scratch_.push_back('"');
+                            break;
+                        case '\\':
+                            scratch_.push_back('\\');
+                            break;
+                        default:
+                            throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                        }
+                    }
+                    else {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+
+                    // Копируем сразу весь участок без кавычек, экранирования и переводов строк
+                    run_begin = cur_;
+                    cur_ = FindStringStop(cur_, end_, scanner_);
+                    scratch_.append(run_begin, cur_);
+                }
+                return scratch_;
+            }
+
+            void ParseBool() {
+                const auto s = ParseLiteral();
+                if (s == "true"sv) {
+                    handler_.Bool(true);
                 }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
+                else if (s == "false"sv) {
+                    handler_.Bool(false);
                 }
                 else {
-                    s.push_back(ch);
+                    throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
                 }
-                ++it;
             }
 
-            return Node(std::move(s));
-        }
-
-        Node LoadBool(std::istream& input) {
-            const auto s = LoadLiteral(input);
-            if (s == "true"sv) {
-                return Node{ true };
-            }
-            else if (s == "false"sv) {
-                return Node{ false };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
-            }
-        }
-
-        Node LoadNull(std::istream& input) {
-            if (auto literal = LoadLiteral(input); literal == "null"sv) {
-                return Node{ nullptr };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+            void ParseNull() {
+                if (auto literal = ParseLiteral(); literal == "null"sv) {
+                    handler_.Null();
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+                }
             }
-        }
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
+            void ParseNumber() {
+                const char* begin = cur_;
 
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
+                // Считывает одну или более цифр
+                auto read_digits = [this] {
+                    if (cur_ == end_ || !IsDigit(*cur_)) {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (cur_ != end_ && IsDigit(*cur_)) {
+                        ++cur_;
+                    }
                 };
 
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
-                    throw ParsingError("A digit is expected"s);
+                if (cur_ != end_ && *cur_ == '-') {
+                    ++cur_;
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                // Парсим целую часть числа
+                if (cur_ != end_ && *cur_ == '0') {
+                    ++cur_;
+                    // После 0 в JSON не могут идти другие цифры
+                }
+                else {
+                    read_digits();
                 }
-                };
-
-            if (input.peek() == '-') {
-                read_char();
-            }
-            // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
-            }
-            else {
-                read_digits();
-            }
 
-            bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
-                read_digits();
-                is_int = false;
-            }
+                bool is_int = true;
+                // Парсим дробную часть числа
+                if (cur_ != end_ && *cur_ == '.') {
+                    ++cur_;
+                    read_digits();
+                    is_int = false;
+                }
 
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+                // Парсим экспоненциальную часть числа
+                if (cur_ != end_ && (*cur_ == 'e' || *cur_ == 'E')) {
+                    ++cur_;
+                    if (cur_ != end_ && (*cur_ == '+' || *cur_ == '-')) {
+                        ++cur_;
+                    }
+                    read_digits();
+                    is_int = false;
                 }
-                read_digits();
-                is_int = false;
-            }
 
-            try {
                 if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении
-                        // код ниже попробует преобразовать строку в double
+                    // При переполнении int число разбирается как double
+                    int int_value;
+                    if (auto [ptr, ec] = std::from_chars(begin, cur_, int_value); ec == std::errc{} && ptr == cur_) {
+                        handler_.Int(int_value);
+                        return;
                     }
                 }
-                return std::stod(parsed_num);
+                double double_value;
+                if (auto [ptr, ec] = std::from_chars(begin, cur_, double_value); ec == std::errc{} && ptr == cur_) {
+                    handler_.Double(double_value);
+                    return;
+                }
+                throw ParsingError("Failed to convert "s + std::string(begin, cur_) + " to number"s);
             }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+
+            const char* cur_;
+            const char* end_;
+            const Scanner& scanner_;
+            Handler& handler_;
+            std::string scratch_;
+        };
+
+        std::string ReadAll(std::istream& input) {
+            std::string buffer;
+            char chunk[1 << 16];
+            while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+                buffer.append(chunk, static_cast<size_t>(input.gcount()));
             }
+            return buffer;
         }
 
-        Node LoadNode(std::istream& input) {
-            char c;
-            if (!(input >> c)) {
-                throw ParsingError("Unexpected EOF"s);
-            }
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-                // подсказкой компилятору и человеку, что здесь программист явно задумывал
-                // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-                // написать break, return или throw.
-                // В данном случае, встретив t или f, переходим к попытке парсинга
-                // литералов true либо false
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
-            }
+    }  // namespace
+
+    void DomHandler::Null() {
+        AddValue(nullptr);
+    }
+
+    void DomHandler::Bool(bool value) {
+        AddValue(value);
+    }
+
+    void DomHandler::Int(int value) {
+        AddValue(value);
+    }
+
+    void DomHandler::Double(double value) {
+        AddValue(value);
+    }
+
+    void DomHandler::String(std::string_view value) {
+        AddValue(std::string(value));
+    }
+
+    void DomHandler::StartArray() {
+        stack_.emplace_back(Array{});
+    }
+
+    void DomHandler::EndArray() {
+        CloseContainer();
+    }
+
+    void DomHandler::StartDict() {
+        stack_.emplace_back(Dict{});
+    }
+
+    void DomHandler::Key(std::string_view key) {
+        const Dict& dict = std::get<Dict>(stack_.back().GetValue());
+        if (dict.find(key) != dict.end()) {
+            throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
         }
+        keys_.emplace_back(key);
+    }
 
-        struct PrintContext {
-            std::ostream& out;
-            int indent_step = 4;
-            int indent = 0;
+    void DomHandler::EndDict() {
+        CloseContainer();
+    }
 
-            void PrintIndent() const {
-                for (int i = 0; i < indent; ++i) {
-                    out.put(' ');
-                }
-            }
+    Node DomHandler::Extract() {
+        return std::move(root_);
+    }
 
-            PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
-            }
-        };
+    void DomHandler::CloseContainer() {
+        Node container = std::move(stack_.back());
+        stack_.pop_back();
+        AddValue(std::move(container));
+    }
 
-        void PrintNode(const Node& value, const PrintContext& ctx);
+    void DomHandler::AddValue(Node value) {
+        if (stack_.empty()) {
+            root_ = std::move(value);
+            return;
+        }
+        Node::Value& parent = stack_.back().GetValue();
+        if (Array* array = std::get_if<Array>(&parent)) {
+            array->push_back(std::move(value));
+        }
+        else {
+            std::get<Dict>(parent).emplace(std::move(keys_.back()), std::move(value));
+            keys_.pop_back();
+        }
+    }
 
-        template <typename Value>
-        void PrintValue(const Value& value, const PrintContext& ctx) {
-            ctx.out << value;
+    void Parse(std::string_view input, Handler& handler) {
+        Parser(input, handler).ParseNode();
+    }
+
+    void Parse(std::istream& input, Handler& handler) {
+        const std::string buffer = ReadAll(input);
+        Parse(std::string_view(buffer), handler);
+    }
+
+    Document Load(std::string_view input) {
+        PROFILE_SCOPE("json::Load");
+        DomHandler handler;
+        Parse(input, handler);
+        return Document{ handler.Extract() };
+    }
+
+    Document Load(std::istream& input) {
+        const std::string buffer = ReadAll(input);
+        return Load(std::string_view(buffer));
+    }
+
+    Writer::Writer(std::ostream& output, size_t base_level)
+        : output_(output)
+        , base_level_(base_level)
+        , precision_(static_cast<int>(output.precision())) {
+    }
+
+    Writer::~Writer() {
+        try {
+            Flush();
+        }
+        catch (...) {
         }
+    }
 
-        void PrintString(const std::string& value, std::ostream& out) {
-            out.put('"');
-            for (const char c : value) {
-                switch (c) {
-                case '\r':
-                    out << "\\r"sv;
-                    break;
-                case '\n':
-                    out << "\\n"sv;
-                    break;
-                case '\t':
-                    out << "\\t"sv;
-                    break;
-                case '"':
-                    // Символы " и \ выводятся как \" или \\, соответственно
-                    [[fallthrough]];
-                case '\\':
-                    out.put('\\');
-                    [[fallthrough]];
-                default:
-                    out.put(c);
-                    break;
-                }
-            }
-            out.put('"');
+    Writer& Writer::StartArray() {
+        BeginValue();
+        buffer_ += "[\n"sv;
+        stack_.push_back({ false, true });
+        return *this;
+    }
+
+    Writer& Writer::EndArray() {
+        if (stack_.empty() || stack_.back().is_dict) {
+            throw std::logic_error("EndArray without matching StartArray"s);
         }
+        EndContainer(']');
+        return *this;
+    }
+
+    Writer& Writer::StartDict() {
+        BeginValue();
+        buffer_ += "{\n"sv;
+        stack_.push_back({ true, true });
+        return *this;
+    }
 
-        template <>
-        void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-            PrintString(value, ctx.out);
+    Writer& Writer::Key(std::string_view key) {
+        if (stack_.empty() || !stack_.back().is_dict || after_key_) {
+            throw std::logic_error("Key is allowed only inside a dict"s);
         }
+        BeginItem();
+        WriteString(key);
+        buffer_ += ": "sv;
+        after_key_ = true;
+        return *this;
+    }
 
-        template <>
-        void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-            ctx.out << "null"sv;
+    Writer& Writer::EndDict() {
+        if (stack_.empty() || !stack_.back().is_dict || after_key_) {
+            throw std::logic_error("EndDict without matching StartDict"s);
         }
+        EndContainer('}');
+        return *this;
+    }
+
+    Writer& Writer::Value(const Node& node) {
+        std::visit([this](const auto& value) { WriteValue(value); }, node.GetValue());
+        return *this;
+    }
 
-        // В специализации шаблона PrintValue для типа bool параметр value передаётся
-        // по константной ссылке, как и в основном шаблоне.
-        // В качестве альтернативы можно использовать перегрузку:
-        // void PrintValue(bool value, const PrintContext& ctx);
-        template <>
-        void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-            ctx.out << (value ? "true"sv : "false"sv);
+    Writer& Writer::RawValue(std::string_view fragment) {
+        BeginValue();
+        buffer_ += fragment;
+        if (buffer_.size() >= FLUSH_THRESHOLD) {
+            Flush();
         }
+        return *this;
+    }
 
-        template <>
-        void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "[\n"sv;
-            bool first = true;
-            auto inner_ctx = ctx.Indented();
-            for (const Node& node : nodes) {
-                if (first) {
-                    first = false;
-                }
-                else {
-                    out << ",\n"sv;
-                }
-                inner_ctx.PrintIndent();
-                PrintNode(node, inner_ctx);
-            }
-            out.put('\n');
-            ctx.PrintIndent();
-            out.put(']');
+    Writer& Writer::StartString() {
+        BeginValue();
+        buffer_ += '"';
+        in_string_ = true;
+        return *this;
+    }
+
+    Writer& Writer::StringPart(std::string_view part) {
+        if (!in_string_) {
+            throw std::logic_error("StringPart without matching StartString"s);
+        }
+        WriteEscaped(part);
+        if (buffer_.size() >= FLUSH_THRESHOLD) {
+            Flush();
         }
+        return *this;
+    }
 
-        template <>
-        void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "{\n"sv;
-            bool first = true;
-            auto inner_ctx = ctx.Indented();
-            for (const auto& [key, node] : nodes) {
-                if (first) {
-                    first = false;
-                }
-                else {
-                    out << ",\n"sv;
-                }
-                inner_ctx.PrintIndent();
-                PrintString(key, ctx.out);
-                out << ": "sv;
-                PrintNode(node, inner_ctx);
+    Writer& Writer::EndString() {
+        if (!in_string_) {
+            throw std::logic_error("EndString without matching StartString"s);
+        }
+        buffer_ += '"';
+        in_string_ = false;
+        return *this;
+    }
+
+    void Writer::Flush() {
+        if (buffer_.empty()) {
+            return;
+        }
+        PROFILE_SCOPE("json::Writer::Flush");
+        output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+    void Writer::BeginValue() {
+        if (after_key_) {
+            after_key_ = false;
+        }
+        else if (!stack_.empty()) {
+            if (stack_.back().is_dict) {
+                throw std::logic_error("Value inside a dict must follow a key"s);
             }
-            out.put('\n');
-            ctx.PrintIndent();
-            out.put('}');
+            BeginItem();
         }
+    }
 
-        void PrintNode(const Node& node, const PrintContext& ctx) {
-            std::visit(
-                [&ctx](const auto& value) {
-                    PrintValue(value, ctx);
-                },
-                node.GetValue());
+    // Разделитель и отступ перед очередным элементом массива или ключом словаря
+    void Writer::BeginItem() {
+        Level& level = stack_.back();
+        if (level.first) {
+            level.first = false;
         }
+        else {
+            buffer_ += ",\n"sv;
+        }
+        WriteIndent(stack_.size());
+    }
 
-    }  // namespace
+    void Writer::EndContainer(char close) {
+        stack_.pop_back();
+        buffer_ += '\n';
+        WriteIndent(stack_.size());
+        buffer_ += close;
+        if (buffer_.size() >= FLUSH_THRESHOLD) {
+            Flush();
+        }
+    }
 
-    Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+    void Writer::WriteIndent(size_t level) {
+        buffer_.append((base_level_ + level) * INDENT_STEP, ' ');
+    }
+
+    void Writer::WriteValue(std::nullptr_t) {
+        BeginValue();
+        buffer_ += "null"sv;
+    }
+
+    void Writer::WriteValue(bool value) {
+        BeginValue();
+        buffer_ += value ? "true"sv : "false"sv;
+    }
+
+    void Writer::WriteValue(int value) {
+        BeginValue();
+        number_format::AppendInt(buffer_, value);
+    }
+
+    // Тот же формат, что даёт operator<< потока с его текущей точностью
+    void Writer::WriteValue(double value) {
+        BeginValue();
+        number_format::AppendDouble(buffer_, value, precision_);
+    }
+
+    void Writer::WriteValue(const std::string& value) {
+        BeginValue();
+        WriteString(value);
+    }
+
+    void Writer::WriteValue(const Array& nodes) {
+        StartArray();
+        for (const Node& node : nodes) {
+            Value(node);
+        }
+        EndArray();
+    }
+
+    void Writer::WriteValue(const Dict& nodes) {
+        StartDict();
+        for (const auto& [key, node] : nodes) {
+            Key(key);
+            Value(node);
+        }
+        EndDict();
+    }
+
+    void Writer::WriteString(std::string_view value) {
+        buffer_ += '"';
+        WriteEscaped(value);
+        buffer_ += '"';
+        if (buffer_.size() >= FLUSH_THRESHOLD) {
+            Flush();
+        }
+    }
+
+    void Writer::WriteEscaped(std::string_view value) {
+        for (const char c : value) {
+            switch (c) {
+            case '\r':
+                buffer_ += "\\r"sv;
+                break;
+            case '\n':
+                buffer_ += "\\n"sv;
+                break;
+            case '\t':
+                buffer_ += "\\t"sv;
+                break;
+            case '"':
+                // Символы " и \ выводятся как \" или \\, соответственно
+                [[fallthrough]];
+            case '\\':
+                buffer_ += '\\';
+                [[fallthrough]];
+            default:
+                buffer_ += c;
+                break;
+            }
+        }
+    }
+
+    StringValueBuf::int_type StringValueBuf::overflow(int_type c) {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            const char ch = traits_type::to_char_type(c);
+            writer_.StringPart({ &ch, 1 });
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize StringValueBuf::xsputn(const char* s, std::streamsize count) {
+        writer_.StringPart({ s, static_cast<size_t>(count) });
+        return count;
     }
 
     void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), PrintContext{ output });
+        PROFILE_SCOPE("json::Print");
+        Writer writer(output);
+        writer.Value(doc.GetRoot());
+        writer.Flush();
     }
 
 }  // namespace json
\ No newline at end of file
@@ -2,14 +2,16 @@
 
 #include <iostream>
 #include <map>
+#include <streambuf>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
+    using Dict = std::map<std::string, Node, std::less<>>;
     using Array = std::vector<Node>;
 
     class ParsingError : public std::runtime_error {
@@ -140,8 +142,145 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    /*
+     * Обработчик событий разбора. Парсер вызывает методы в порядке следования элементов
+     * документа; строки и ключи передаются как string_view, действительные только во время вызова
+     */
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void Null() = 0;
+        virtual void Bool(bool value) = 0;
+        virtual void Int(int value) = 0;
+        virtual void Double(double value) = 0;
+        virtual void String(std::string_view value) = 0;
+
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void StartDict() = 0;
+        virtual void Key(std::string_view key) = 0;
+        virtual void EndDict() = 0;
+    };
+
+    // Обработчик, собирающий из событий дерево Node
+    class DomHandler final : public Handler {
+    public:
+        void Null() override;
+        void Bool(bool value) override;
+        void Int(int value) override;
+        void Double(double value) override;
+        void String(std::string_view value) override;
+
+        void StartArray() override;
+        void EndArray() override;
+        void StartDict() override;
+        void Key(std::string_view key) override;
+        void EndDict() override;
+
+        Node Extract();
+
+    private:
+        void CloseContainer();
+        void AddValue(Node value);
+
+        Node root_;
+        std::vector<Node> stack_;
+        std::vector<std::string> keys_;
+    };
+
+    // Разбирает документ, передавая события обработчику
+    void Parse(std::string_view input, Handler& handler);
+    void Parse(std::istream& input, Handler& handler);
+
+    // Разбирает документ из буфера в памяти
+    Document Load(std::string_view input);
+    // Читает поток до конца и разбирает прочитанное как документ
     Document Load(std::istream& input);
 
+    /*
+     * Последовательная запись JSON в том же формате, что и Print: отступ в 4 пробела,
+     * каждый элемент и ключ с новой строки. Текст копится во внутреннем буфере
+     * и сбрасывается в поток по мере заполнения, поэтому большой документ
+     * не нужно целиком собирать в Node перед выводом
+     */
+    class Writer {
+    public:
+        // base_level - уровень вложенности, на котором окажется записанный текст;
+        // позволяет готовить фрагменты для последующей вставки через RawValue
+        explicit Writer(std::ostream& output, size_t base_level = 0);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer();
+
+        Writer& StartArray();
+        Writer& EndArray();
+        Writer& StartDict();
+        Writer& Key(std::string_view key);
+        Writer& EndDict();
+        // Записывает значение целиком, включая вложенные массивы и словари
+        Writer& Value(const Node& node);
+        // Вставляет уже сериализованное значение, подготовленное на этом же уровне вложенности
+        Writer& RawValue(std::string_view fragment);
+        // Строковое значение, записываемое по частям: каждая часть экранируется и дописывается
+        // к предыдущим, поэтому длинную строку не нужно собирать целиком
+        Writer& StartString();
+        Writer& StringPart(std::string_view part);
+        Writer& EndString();
+
+        void Flush();
+
+    private:
+        struct Level {
+            bool is_dict;
+            bool first;
+        };
+
+        static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+        static constexpr size_t INDENT_STEP = 4;
+
+        void BeginValue();
+        void BeginItem();
+        void EndContainer(char close);
+        void WriteIndent(size_t level);
+        void WriteString(std::string_view value);
+        void WriteEscaped(std::string_view value);
+
+        void WriteValue(std::nullptr_t);
+        void WriteValue(bool value);
+        void WriteValue(int value);
+        void WriteValue(double value);
+        void WriteValue(const std::string& value);
+        void WriteValue(const Array& nodes);
+        void WriteValue(const Dict& nodes);
+
+        std::ostream& output_;
+        size_t base_level_;
+        int precision_;
+        std::string buffer_;
+        std::vector<Level> stack_;
+        bool after_key_ = false;
+        bool in_string_ = false;
+    };
+
+    /*
+     * Буфер потока, передающий всё записанное в Writer::StringPart. Позволяет записать
+     * в открытое через StartString значение вывод, рассчитанный на std::ostream
+     */
+    class StringValueBuf final : public std::streambuf {
+    public:
+        explicit StringValueBuf(Writer& writer)
+            : writer_(writer) {
+        }
+
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+    private:
+        Writer& writer_;
+    };
+
     void Print(const Document& doc, std::ostream& output);
 
 }  // namespace json
\ No newline at end of file
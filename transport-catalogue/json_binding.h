@@ -0,0 +1,201 @@
+// json_binding.h
+
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+    /*
+     * Чтение значения типа T из узла. Node - json::Node или json::TapeNode.
+     * Для своих типов достаточно специализировать шаблон со статическим методом
+     * template <typename Node> static void Read(const Node& node, T& value)
+     */
+    template <typename T>
+    struct ValueReader;
+
+    template <>
+    struct ValueReader<bool> {
+        template <typename Node>
+        static void Read(const Node& node, bool& value) {
+            value = node.AsBool();
+        }
+    };
+
+    template <>
+    struct ValueReader<int> {
+        template <typename Node>
+        static void Read(const Node& node, int& value) {
+            value = node.AsInt();
+        }
+    };
+
+    template <>
+    struct ValueReader<double> {
+        template <typename Node>
+        static void Read(const Node& node, double& value) {
+            value = node.AsDouble();
+        }
+    };
+
+    // Указывает в документ, поэтому действительна, пока он жив
+    template <>
+    struct ValueReader<std::string_view> {
+        template <typename Node>
+        static void Read(const Node& node, std::string_view& value) {
+            value = node.AsString();
+        }
+    };
+
+    template <>
+    struct ValueReader<std::string> {
+        template <typename Node>
+        static void Read(const Node& node, std::string& value) {
+            value = node.AsString();
+        }
+    };
+
+    template <typename T>
+    struct ValueReader<std::optional<T>> {
+        template <typename Node>
+        static void Read(const Node& node, std::optional<T>& value) {
+            ValueReader<T>::Read(node, value.emplace());
+        }
+    };
+
+    template <typename T>
+    struct ValueReader<std::vector<T>> {
+        template <typename Node>
+        static void Read(const Node& node, std::vector<T>& value) {
+            const auto& array = node.AsArray();
+            value.clear();
+            value.reserve(array.size());
+            for (const auto& item : array) {
+                ValueReader<T>::Read(item, value.emplace_back());
+            }
+        }
+    };
+
+    // Первые два элемента массива; остальные игнорируются
+    template <typename First, typename Second>
+    struct ValueReader<std::pair<First, Second>> {
+        template <typename Node>
+        static void Read(const Node& node, std::pair<First, Second>& value) {
+            using namespace std::literals;
+            const auto& array = node.AsArray();
+            auto it = array.begin();
+            if (it == array.end()) {
+                throw std::out_of_range("Pair expects two array items"s);
+            }
+            ValueReader<First>::Read(*it, value.first);
+            if (++it == array.end()) {
+                throw std::out_of_range("Pair expects two array items"s);
+            }
+            ValueReader<Second>::Read(*it, value.second);
+        }
+    };
+
+    template <typename T>
+    struct ValueReader<std::unordered_map<std::string, T>> {
+        template <typename Node>
+        static void Read(const Node& node, std::unordered_map<std::string, T>& value) {
+            value.clear();
+            for (const auto& [key, item] : node.AsDict()) {
+                ValueReader<T>::Read(item, value[std::string(key)]);
+            }
+        }
+    };
+
+    // Ключ JSON и поле структуры, в которое записывается его значение
+    template <typename Struct, typename Member>
+    struct FieldDescriptor {
+        std::string_view key;
+        Member Struct::* member;
+        bool required;
+    };
+
+    template <typename Struct, typename Member>
+    constexpr FieldDescriptor<Struct, Member> Required(std::string_view key, Member Struct::* member) {
+        return { key, member, true };
+    }
+
+    // Если ключа нет, поле сохраняет значение по умолчанию
+    template <typename Struct, typename Member>
+    constexpr FieldDescriptor<Struct, Member> Optional(std::string_view key, Member Struct::* member) {
+        return { key, member, false };
+    }
+
+    /*
+     * Описание полей структуры. Специализация должна содержать
+     * static constexpr auto FIELDS = std::tuple{ Required(...), Optional(...), ... };
+     */
+    template <typename Struct>
+    struct Binding;
+
+    namespace detail {
+
+        template <typename Struct>
+        inline constexpr size_t FIELD_COUNT = std::tuple_size_v<std::decay_t<decltype(Binding<Struct>::FIELDS)>>;
+
+        // Сравнения с ключами разворачиваются на этапе компиляции в цепочку проверок длины и memcmp
+        template <typename Struct, typename Node, size_t... Is>
+        void ReadField(std::string_view key, const Node& value, Struct& result, uint64_t& seen, std::index_sequence<Is...>) {
+            constexpr const auto& fields = Binding<Struct>::FIELDS;
+            (void)((key == std::get<Is>(fields).key
+                && (ValueReader<std::decay_t<decltype(result.*(std::get<Is>(fields).member))>>::Read(
+                    value, result.*(std::get<Is>(fields).member)), seen |= uint64_t{ 1 } << Is, true))
+                || ...);
+        }
+
+        template <typename Struct, size_t... Is>
+        void CheckRequired(uint64_t seen, std::index_sequence<Is...>) {
+            using namespace std::literals;
+            constexpr const auto& fields = Binding<Struct>::FIELDS;
+            (void)(((std::get<Is>(fields).required && (seen & (uint64_t{ 1 } << Is)) == 0
+                ? throw ParsingError("Missing field '"s + std::string(std::get<Is>(fields).key) + "'"s)
+                : void()), ...));
+        }
+
+    }  // namespace detail
+
+    /*
+     * Заполняет структуру из словаря за один проход по его ключам, без поиска каждого поля
+     * по имени. Source - узел со словарём или сам словарь (json::Dict, json::TapeDict).
+     * Неизвестные ключи пропускаются; при отсутствии обязательного бросает ParsingError
+     */
+    template <typename Struct, typename Source>
+    void Decode(const Source& source, Struct& result) {
+        if constexpr (requires { source.AsDict(); }) {
+            Decode(source.AsDict(), result);
+        }
+        else {
+            constexpr size_t field_count = detail::FIELD_COUNT<Struct>;
+            static_assert(field_count <= 64, "Too many fields");
+            using Indices = std::make_index_sequence<field_count>;
+
+            uint64_t seen = 0;
+            for (const auto& [key, value] : source) {
+                detail::ReadField(key, value, result, seen, Indices{});
+            }
+            detail::CheckRequired<Struct>(seen, Indices{});
+        }
+    }
+
+    template <typename Struct, typename Source>
+    Struct Decode(const Source& source) {
+        Struct result;
+        Decode(source, result);
+        return result;
+    }
+
+}  // namespace json
@@ -2,71 +2,533 @@
 
 #include "json_reader.h"
 #include "json.h"
+#include "json_binding.h"
 #include "json_builder.h"
 #include "map_renderer.h"
+#include "profiler.h"
+#include "serialization.h"
+#include "snapshot.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 #include <unordered_map>
 #include <sstream>
-
+#include <thread>
+#include <tuple>
+#include <utility>
+
+namespace json {
+
+    // Строка с именем цвета или массив из 3 (Rgb) либо 4 (Rgba) элементов
+    template <>
+    struct ValueReader<svg::Color> {
+        template <typename Node>
+        static void Read(const Node& node, svg::Color& value) {
+            if (node.IsArray()) {
+                const auto& array = node.AsArray();
+                const size_t size = array.size();
+                if (size == 3 || size == 4) {
+                    auto it = array.begin();
+                    const auto red = static_cast<uint8_t>((*it++).AsInt());
+                    const auto green = static_cast<uint8_t>((*it++).AsInt());
+                    const auto blue = static_cast<uint8_t>((*it++).AsInt());
+                    if (size == 4) {
+                        value = svg::Rgba{ red, green, blue, (*it).AsDouble() };
+                    }
+                    else {
+                        value = svg::Rgb{ red, green, blue };
+                    }
+                    return;
+                }
+            }
+            value = std::string(node.AsString());
+        }
+    };
+
+    template <>
+    struct Binding<transport::catalogue::StopRequest> {
+        using Request = transport::catalogue::StopRequest;
+        static constexpr auto FIELDS = std::tuple{
+            Required("name", &Request::name),
+            Required("latitude", &Request::latitude),
+            Required("longitude", &Request::longitude),
+            Required("road_distances", &Request::road_distances),
+        };
+    };
+
+    template <>
+    struct Binding<transport::catalogue::BusRequest> {
+        using Request = transport::catalogue::BusRequest;
+        static constexpr auto FIELDS = std::tuple{
+            Required("name", &Request::name),
+            Required("stops", &Request::stops),
+            Required("is_roundtrip", &Request::is_roundtrip),
+        };
+    };
+
+    template <>
+    struct Binding<transport::catalogue::InfoRequest> {
+        using Request = transport::catalogue::InfoRequest;
+        static constexpr auto FIELDS = std::tuple{
+            Required("id", &Request::id),
+            Required("name", &Request::name),
+        };
+    };
+
+    template <>
+    struct Binding<transport::catalogue::MapRequest> {
+        using Request = transport::catalogue::MapRequest;
+        static constexpr auto FIELDS = std::tuple{
+            Required("id", &Request::id),
+        };
+    };
+
+    template <>
+    struct Binding<transport::catalogue::RouteRequest> {
+        using Request = transport::catalogue::RouteRequest;
+        static constexpr auto FIELDS = std::tuple{
+            Required("id", &Request::id),
+            Required("from", &Request::from),
+            Required("to", &Request::to),
+        };
+    };
+
+    template <>
+    struct Binding<transport::catalogue::RenderSettings> {
+        using Settings = transport::catalogue::RenderSettings;
+        static constexpr auto FIELDS = std::tuple{
+            Required("width", &Settings::width),
+            Required("height", &Settings::height),
+            Required("padding", &Settings::padding),
+            Required("stop_radius", &Settings::stop_radius),
+            Required("line_width", &Settings::line_width),
+            Required("bus_label_font_size", &Settings::bus_label_font_size),
+            Required("bus_label_offset", &Settings::bus_label_offset),
+            Required("stop_label_font_size", &Settings::stop_label_font_size),
+            Required("stop_label_offset", &Settings::stop_label_offset),
+            Required("underlayer_color", &Settings::underlayer_color),
+            Required("underlayer_width", &Settings::underlayer_width),
+            Required("color_palette", &Settings::color_palette),
+        };
+    };
+
+}  // namespace json
 
 namespace transport {
     namespace catalogue {
 
-        void JsonReader::LoadData(const json::Document& doc) {
-            const auto& base_requests = doc.GetRoot().AsDict().at("base_requests").AsArray();
-            for (const auto& request : base_requests) {
-                const auto& request_map = request.AsDict();
-                const auto& Request = request_map.at("type").AsString();
-                if (Request == "Stop") {
-                    std::string stop_name = request_map.at("name").AsString();
-                    double lat = request_map.at("latitude").AsDouble();
-                    double lng = request_map.at("longitude").AsDouble();
-                    std::unordered_map<std::string, int> distances;
-                    for (const auto& [name, distance] : request_map.at("road_distances").AsDict()) {
-                        distances[name] = distance.AsInt();
+        namespace {
+            using namespace std::literals;
+
+            // Добавляет в справочник одну запись base_requests; Request - json::Node или json::TapeNode
+            template <typename Request>
+            void AddBaseRequest(const Request& request, TransportCatalogue& catalogue) {
+                const std::string_view type = request.AsDict().at("type").AsString();
+                if (type == "Stop") {
+                    auto stop = json::Decode<StopRequest>(request);
+                    catalogue.AddStop(stop.name, { stop.latitude, stop.longitude }, stop.road_distances);
+                }
+                else if (type == "Bus") {
+                    const auto bus = json::Decode<BusRequest>(request);
+                    catalogue.AddBus(bus.name, bus.stops, bus.is_roundtrip);
+                }
+            }
+
+            // Заполняет справочник из base_requests; Root - json::Node или json::TapeNode
+            template <typename Root>
+            void AddBaseRequests(const Root& root, TransportCatalogue& catalogue) {
+                const auto& base_requests = root.AsDict().at("base_requests").AsArray();
+                for (const auto& request : base_requests) {
+                    AddBaseRequest(request, catalogue);
+                }
+            }
+
+            /*
+             * Обработчик разбора входного документа. Каждая запись base_requests собирается
+             * в небольшое дерево и сразу попадает в справочник, остальные разделы корневого
+             * словаря собираются в обычное дерево. Ошибки в содержимом откладываются до конца
+             * разбора, чтобы исключения были теми же, что у json::Load с AddBaseRequests:
+             * синтаксическая ошибка в любом месте документа важнее
+             */
+            class StreamingLoader final : public json::Handler {
+            public:
+                StreamingLoader(TransportCatalogue& catalogue, bool with_base_requests)
+                    : catalogue_(catalogue)
+                    , with_base_requests_(with_base_requests) {
+                }
+
+                void Null() override {
+                    StartValue();
+                    dom_.Null();
+                    EndValue();
+                }
+                void Bool(bool value) override {
+                    StartValue();
+                    dom_.Bool(value);
+                    EndValue();
+                }
+                void Int(int value) override {
+                    StartValue();
+                    dom_.Int(value);
+                    EndValue();
+                }
+                void Double(double value) override {
+                    StartValue();
+                    dom_.Double(value);
+                    EndValue();
+                }
+                void String(std::string_view value) override {
+                    StartValue();
+                    dom_.String(value);
+                    EndValue();
+                }
+
+                void StartArray() override {
+                    if (capture_depth_ < 0 && depth_ == 1 && section_key_ == "base_requests"sv) {
+                        in_base_requests_ = true;
+                    }
+                    else {
+                        StartValue();
+                        dom_.StartArray();
+                    }
+                    ++depth_;
+                }
+
+                void EndArray() override {
+                    --depth_;
+                    if (capture_depth_ < 0) {
+                        in_base_requests_ = false;
+                    }
+                    else {
+                        dom_.EndArray();
+                        EndValue();
                     }
-                    catalogue_.AddStop(std::move(stop_name), { lat, lng }, distances);
                 }
-                else if (Request == "Bus") {
-                    std::string bus_name = request_map.at("name").AsString();
-                    bool is_circular = request_map.at("is_roundtrip").AsBool();
 
-                    std::vector<std::string> stops;
-                    for (const auto& stop_name : request_map.at("stops").AsArray()) {
-                        stops.push_back(stop_name.AsString());
+                void StartDict() override {
+                    if (capture_depth_ < 0 && depth_ == 0) {
+                        root_is_dict_ = true;
                     }
-                    catalogue_.AddBus(std::move(bus_name), std::move(stops), is_circular);
+                    else {
+                        StartValue();
+                        dom_.StartDict();
+                    }
+                    ++depth_;
+                }
+
+                void Key(std::string_view key) override {
+                    if (capture_depth_ >= 0) {
+                        dom_.Key(key);
+                        return;
+                    }
+                    const bool duplicate = key == "base_requests"sv
+                        ? std::exchange(has_base_requests_, true)
+                        : rest_.find(key) != rest_.end();
+                    if (duplicate) {
+                        throw json::ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+                    }
+                    section_key_ = key;
                 }
+
+                void EndDict() override {
+                    --depth_;
+                    if (capture_depth_ >= 0) {
+                        dom_.EndDict();
+                        EndValue();
+                    }
+                }
+
+                json::Document ExtractRest() {
+                    if (error_) {
+                        std::rethrow_exception(error_);
+                    }
+                    json::Node root = root_is_dict_ ? json::Node(std::move(rest_)) : std::move(root_);
+                    if (with_base_requests_ && !has_base_requests_) {
+                        // То же исключение, что бросила бы AddBaseRequests
+                        static_cast<void>(root.AsDict().at("base_requests"s));
+                    }
+                    return json::Document(std::move(root));
+                }
+
+            private:
+                // Всё, кроме корневого словаря и массива base_requests, собирается в dom_
+                void StartValue() {
+                    if (capture_depth_ < 0) {
+                        capture_depth_ = depth_;
+                    }
+                }
+
+                void EndValue() {
+                    if (depth_ != capture_depth_) {
+                        return;
+                    }
+                    capture_depth_ = -1;
+                    json::Node value = dom_.Extract();
+                    if (depth_ == 0) {
+                        root_ = std::move(value);
+                    }
+                    else if (in_base_requests_) {
+                        if (with_base_requests_) {
+                            Defer([&] { AddBaseRequest(value, catalogue_); });
+                        }
+                    }
+                    else if (section_key_ == "base_requests"sv) {
+                        if (with_base_requests_) {
+                            Defer([&] { value.AsArray(); });
+                        }
+                    }
+                    else {
+                        rest_.emplace(std::move(section_key_), std::move(value));
+                    }
+                }
+
+                // После первой ошибки записи только разбираются, как и в AddBaseRequests
+                template <typename Action>
+                void Defer(Action action) {
+                    if (error_) {
+                        return;
+                    }
+                    try {
+                        action();
+                    }
+                    catch (...) {
+                        error_ = std::current_exception();
+                    }
+                }
+
+                TransportCatalogue& catalogue_;
+                bool with_base_requests_;
+                int depth_ = 0;
+                // глубина, с которой начато значение, собираемое в dom_; -1 - ничего не собирается
+                int capture_depth_ = -1;
+
+                bool root_is_dict_ = false;
+                bool has_base_requests_ = false;
+                bool in_base_requests_ = false;
+                std::string section_key_;
+                json::DomHandler dom_;
+                json::Node root_;
+                json::Dict rest_;
+                std::exception_ptr error_;
+            };
+
+            // Карта выводится в строковое значение JSON по мере отрисовки, без промежуточного текста SVG
+            void WriteMapValue(json::Writer& writer, const RenderSettings& settings, const TransportCatalogue& catalogue) {
+                writer.StartString();
+                {
+                    json::StringValueBuf buffer(writer);
+                    std::ostream svg_output(&buffer);
+                    MapRenderer(settings).StreamMap(catalogue, svg_output);
+                }
+                writer.EndString();
+            }
+
+        } // namespace
+
+        // Разбор и заполнение справочника идут одним проходом, поэтому отдельного json::Load здесь нет
+        json::Document JsonReader::LoadData(std::istream& input, bool with_base_requests) {
+            PROFILE_SCOPE("JsonReader::LoadData");
+            StreamingLoader loader(catalogue_, with_base_requests);
+            json::Parse(input, loader);
+            return loader.ExtractRest();
+        }
+
+        void JsonReader::SaveSnapshot(std::ostream& output, const json::Document& doc) {
+            PROFILE_SCOPE("SaveSnapshot");
+            const auto& root = doc.GetRoot().AsDict();
+            if (!transport_router_.has_value() && root.find("routing_settings") != root.end()) {
+                transport_router_.emplace(GetRoutingSettings(doc), catalogue_);
+            }
+
+            snapshot::WriteHeader(output);
+            snapshot::SaveCatalogue(output, catalogue_);
+            serialization::WritePod<uint8_t>(output, transport_router_.has_value());
+            if (transport_router_) {
+                transport_router_->Save(output);
             }
         }
 
-        void JsonReader::ProcessRequests(const json::Document& doc, std::ostream& output) {
+        void JsonReader::WriteMappedCatalogue(std::ostream& output) const {
+            MappedCatalogue::Write(output, catalogue_);
+        }
+
+        void JsonReader::LoadSnapshot(std::istream& input) {
+            PROFILE_SCOPE("LoadSnapshot");
+            snapshot::ReadHeader(input);
+            snapshot::LoadCatalogue(input, catalogue_);
+            transport_router_.reset();
+            if (serialization::ReadPod<uint8_t>(input) != 0) {
+                transport_router_.emplace(catalogue_, input);
+            }
+        }
+
+        void JsonReader::LoadData(const json::Document& doc) {
+            AddBaseRequests(doc.GetRoot(), catalogue_);
+        }
+
+        void JsonReader::LoadData(const json::TapeDocument& doc) {
+            AddBaseRequests(doc.GetRoot(), catalogue_);
+        }
+
+        void JsonReader::ProcessRequests(const json::Document& doc, std::ostream& output, size_t thread_count) {
+            PROFILE_SCOPE("ProcessRequests");
             const auto& stat_requests = doc.GetRoot().AsDict().at("stat_requests").AsArray();
-            json::Array responses;
-            for (const auto& request : stat_requests) {
-                const auto& request_map = request.AsDict();
-                int request_id = request_map.at("id").AsInt();
-                const std::string_view type = request_map.at("type").AsString();
-                if (type == "Bus") {
-                    ProcessBusRequest(request_map, request_id, responses);
+            StartRouterBuild(stat_requests, doc);
+            cache_map_ = std::count_if(stat_requests.begin(), stat_requests.end(), [](const json::Node& request) {
+                return request.AsDict().at("type").AsString() == "Map";
+            }) > 1;
+            // Ответы пишутся по одному сразу после обработки запроса
+            json::Writer writer(output);
+            writer.StartArray();
+            if (thread_count > 1) {
+                ProcessRequestsParallel(stat_requests, doc, writer, output.precision(), thread_count);
+            }
+            else {
+                for (const auto& request : stat_requests) {
+                    ProcessRequest(request.AsDict(), doc, writer);
+                }
+            }
+            writer.EndArray();
+            writer.Flush();
+        }
+
+        bool JsonReader::ProcessRequest(const json::Dict& request_map, const json::Document& doc, json::Writer& writer) {
+            const std::string_view type = request_map.at("type").AsString();
+            if (type == "Bus") {
+                PROFILE_SCOPE("Bus request");
+                writer.Value(ProcessBusRequest(json::Decode<InfoRequest>(request_map)));
+            }
+            else if (type == "Stop") {
+                PROFILE_SCOPE("Stop request");
+                writer.Value(ProcessStopRequest(json::Decode<InfoRequest>(request_map)));
+            }
+            else if (type == "Map") {
+                PROFILE_SCOPE("Map request");
+                ProcessMapRequest(json::Decode<MapRequest>(request_map).id, doc, writer);
+            }
+            else if (type == "Route") {
+                PROFILE_SCOPE("Route request");
+                writer.Value(ProcessRouteRequest(json::Decode<RouteRequest>(request_map), doc));
+            }
+            else {
+                return false;
+            }
+            return true;
+        }
+
+        /*
+         * Запросы делятся на пачки по REQUEST_CHUNK_SIZE, которые потоки разбирают по очереди.
+         * Каждый ответ сериализуется в потоке-исполнителе в отдельный фрагмент,
+         * а текущий поток выводит фрагменты в порядке запросов. Потоки не уходят вперёд
+         * больше чем на несколько пачек от уже выведенной, поэтому память ограничена
+         */
+        void JsonReader::ProcessRequestsParallel(const json::Array& stat_requests, const json::Document& doc,
+            json::Writer& writer, std::streamsize precision, size_t thread_count) {
+            constexpr size_t REQUEST_CHUNK_SIZE = 16;
+            const size_t chunks_ahead = 4 * thread_count;
+
+            const size_t request_count = stat_requests.size();
+            const size_t chunk_count = (request_count + REQUEST_CHUNK_SIZE - 1) / REQUEST_CHUNK_SIZE;
+            std::vector<std::string> fragments(request_count);
+            std::vector<bool> chunk_ready(chunk_count, false);
+
+            std::mutex mutex;
+            std::condition_variable state_changed;
+            size_t next_chunk = 0;
+            size_t written_chunks = 0;
+            std::exception_ptr error;
+
+            auto worker = [&] {
+                while (true) {
+                    size_t chunk;
+                    {
+                        std::unique_lock lock(mutex);
+                        state_changed.wait(lock, [&] {
+                            return error || next_chunk >= chunk_count || next_chunk < written_chunks + chunks_ahead;
+                        });
+                        if (error || next_chunk >= chunk_count) {
+                            return;
+                        }
+                        chunk = next_chunk++;
+                    }
+
+                    try {
+                        const size_t end = std::min(request_count, (chunk + 1) * REQUEST_CHUNK_SIZE);
+                        for (size_t i = chunk * REQUEST_CHUNK_SIZE; i < end; ++i) {
+                            std::ostringstream fragment;
+                            fragment.precision(precision);
+                            json::Writer fragment_writer(fragment, 1);
+                            if (ProcessRequest(stat_requests[i].AsDict(), doc, fragment_writer)) {
+                                fragment_writer.Flush();
+                                fragments[i] = fragment.str();
+                            }
+                        }
+                    }
+                    catch (...) {
+                        std::lock_guard lock(mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                        state_changed.notify_all();
+                        return;
+                    }
+
+                    {
+                        std::lock_guard lock(mutex);
+                        chunk_ready[chunk] = true;
+                    }
+                    state_changed.notify_all();
                 }
-                else if (type == "Stop") {
-                    ProcessStopRequest(request_map, request_id, responses);
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+            for (size_t i = 0; i < thread_count; ++i) {
+                threads.emplace_back(worker);
+            }
+
+            for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+                {
+                    std::unique_lock lock(mutex);
+                    state_changed.wait(lock, [&] {
+                        return error || chunk_ready[chunk];
+                    });
+                    if (error) {
+                        break;
+                    }
                 }
-                else if (type == "Map") {
-                    ProcessMapRequest(request_id, doc, responses);
+
+                const size_t end = std::min(request_count, (chunk + 1) * REQUEST_CHUNK_SIZE);
+                for (size_t i = chunk * REQUEST_CHUNK_SIZE; i < end; ++i) {
+                    if (!fragments[i].empty()) {
+                        writer.RawValue(fragments[i]);
+                        std::string().swap(fragments[i]);
+                    }
                 }
-                else if (type == "Route") {
-                    ProcessRouteRequest(request_map, request_id, responses, doc);
+
+                {
+                    std::lock_guard lock(mutex);
+                    ++written_chunks;
                 }
+                state_changed.notify_all();
+            }
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            if (error) {
+                std::rethrow_exception(error);
             }
-            json::Print(json::Document(json::Node(std::move(responses))), output);
         }
 
-        void JsonReader::ProcessBusRequest(const json::Dict& request_map, int request_id, json::Array& responses) {
-            const std::string_view bus_name = request_map.at("name").AsString();
-            std::optional<BusInfo> bus = catalogue_.GetBusInfo(bus_name);
+        json::Node JsonReader::ProcessBusRequest(const InfoRequest& request) {
+            const std::string_view bus_name = request.name;
+            const int request_id = request.id;
+            std::optional<BusInfo> bus = mapped_catalogue_ ? mapped_catalogue_->GetBusInfo(bus_name) : catalogue_.GetBusInfo(bus_name);
             json::Builder builder;
 
             if (bus.has_value()) {
@@ -85,26 +547,33 @@ namespace transport {
                     .EndDict();
             }
 
-            responses.push_back(builder.Build());
+            return builder.Build();
         }
 
-        void JsonReader::ProcessStopRequest(const json::Dict& request_map, int request_id, json::Array& responses) {
-            const std::string& stop_name = request_map.at("name").AsString();
-            const Stop* stop = catalogue_.FindStop(stop_name);
+        json::Node JsonReader::ProcessStopRequest(const InfoRequest& request) {
+            const std::string_view stop_name = request.name;
+            const int request_id = request.id;
+            std::optional<std::vector<std::string_view>> buses;
+            if (mapped_catalogue_) {
+                buses = mapped_catalogue_->GetBusesForStop(stop_name);
+            }
+            else if (catalogue_.FindStop(stop_name)) {
+                buses.emplace();
+                if (auto stop_buses = catalogue_.GetBusesForStop(stop_name)) {
+                    buses->assign(stop_buses->begin(), stop_buses->end());
+                    std::sort(buses->begin(), buses->end());
+                }
+            }
             json::Builder builder;
 
-            if (stop) {
-                auto buses = catalogue_.GetBusesForStop(stop_name);
+            if (buses) {
                 builder.StartDict()
                     .Key("request_id").Value(request_id);
 
-                if (buses && !buses->empty()) {
-                    std::vector<std::string> sorted_buses(buses->begin(), buses->end());
-                    std::sort(sorted_buses.begin(), sorted_buses.end());
-
+                if (!buses->empty()) {
                     auto buses_array = builder.Key("buses").StartArray();
-                    for (const auto& bus : sorted_buses) {
-                        buses_array.Value(bus);
+                    for (const auto bus : *buses) {
+                        buses_array.Value(std::string(bus));
                     }
                     buses_array.EndArray();
                 }
@@ -121,23 +590,42 @@ namespace transport {
                     .EndDict();
             }
 
-            responses.push_back(builder.Build());
+            return builder.Build();
         }
 
-        void JsonReader::ProcessMapRequest(int request_id, const json::Document& doc, json::Array& responses) {
+        // Ключи словаря выводятся по алфавиту, поэтому "map" идёт перед "request_id"
+        void JsonReader::ProcessMapRequest(int request_id, const json::Document& doc, json::Writer& writer) {
+            writer.StartDict().Key("map");
+            if (const auto map_json = GetMapJson(doc)) {
+                writer.RawValue(*map_json);
+            }
+            else {
+                WriteMapValue(writer, GetRenderSettings(doc), catalogue_);
+            }
+            writer.Key("request_id").Value(request_id).EndDict();
+        }
+
+        // Повторные запросы Map к неизменному справочнику получают уже отрисованную и экранированную карту.
+        // Если в пачке запрос Map один, карта не запоминается и nullptr означает вывод напрямую в ответ
+        std::shared_ptr<const std::string> JsonReader::GetMapJson(const json::Document& doc) {
             auto render_settings = GetRenderSettings(doc);
-            MapRenderer map_renderer(render_settings);
+            const uint64_t catalogue_version = catalogue_.GetVersion();
 
-            std::ostringstream map_output;
-            map_renderer.RenderMap(catalogue_, map_output);
+            std::lock_guard lock(map_cache_mutex_);
+            if (map_cache_ && map_cache_->catalogue_version == catalogue_version && map_cache_->settings == render_settings) {
+                return map_cache_->map_json;
+            }
+            if (!cache_map_) {
+                return nullptr;
+            }
 
-            json::Builder builder;
-            builder.StartDict()
-                .Key("request_id").Value(request_id)
-                .Key("map").Value(map_output.str())
-                .EndDict();
+            std::ostringstream map_json;
+            json::Writer map_writer(map_json);
+            WriteMapValue(map_writer, render_settings, catalogue_);
+            map_writer.Flush();
 
-            responses.push_back(builder.Build());
+            map_cache_ = MapCache{ catalogue_version, std::move(render_settings), std::make_shared<const std::string>(std::move(map_json).str()) };
+            return map_cache_->map_json;
         }
 
         RoutingSettings GetRoutingSettings(const json::Document& doc) {
@@ -146,26 +634,51 @@ namespace transport {
 
             settings.bus_velocity = routing_settings.at("bus_velocity").AsInt();
             settings.bus_wait_time = routing_settings.at("bus_wait_time").AsInt();
+            if (const auto it = routing_settings.find("use_contraction_hierarchies");
+                it != routing_settings.end() && it->second.AsBool()) {
+                settings.router_mode = RouterMode::CONTRACTION_HIERARCHIES;
+            }
+            if (const auto it = routing_settings.find("graph_model");
+                it != routing_settings.end() && it->second.AsString() == "ride_segments") {
+                settings.graph_model = GraphModel::RIDE_SEGMENTS;
+            }
 
             return settings;
         }
 
-        void JsonReader::ProcessRouteRequest(const json::Dict& request_map, int request_id, json::Array& responses, const json::Document& doc) {
-
-            const std::string& from_stop_name = request_map.at("from").AsString();
-            const std::string& to_stop_name = request_map.at("to").AsString();
-
-            auto routing_settings = GetRoutingSettings(doc);
+        // Построение графа и предрасчёт идут в отдельном потоке, а запросы Route ждут только его готовности.
+        // Настройки читаются заранее: документ может быть уничтожен раньше, чем JsonReader
+        void JsonReader::StartRouterBuild(const json::Array& stat_requests, const json::Document& doc) {
+            if (transport_router_.has_value() || router_ready_.valid()) {
+                return;
+            }
+            const bool has_route_requests = std::any_of(stat_requests.begin(), stat_requests.end(), [](const json::Node& request) {
+                return request.AsDict().at("type").AsString() == "Route";
+            });
+            if (!has_route_requests) {
+                return;
+            }
+            router_ready_ = std::async(std::launch::async, [this, settings = GetRoutingSettings(doc)] {
+                transport_router_.emplace(settings, catalogue_);
+            }).share();
+        }
 
+        const TransportRouter& JsonReader::GetRouter(const json::Document& doc) {
+            if (router_ready_.valid()) {
+                router_ready_.get(); // пробрасывает исключение из потока построения
+            }
             if (!transport_router_.has_value()) {
-                transport_router_.emplace(routing_settings, catalogue_);
+                transport_router_.emplace(GetRoutingSettings(doc), catalogue_);
             }
-            
-            const auto& route_result = transport_router_.value().GetRoute(from_stop_name, to_stop_name);
+            return transport_router_.value();
+        }
+
+        json::Node JsonReader::ProcessRouteRequest(const RouteRequest& request, const json::Document& doc) {
+            const auto& route_result = GetRouter(doc).GetRoute(request.from, request.to);
 
             json::Builder builder;
             builder.StartDict()
-                .Key("request_id").Value(request_id);
+                .Key("request_id").Value(request.id);
 
             if (route_result) {
                 double total_time;
@@ -203,66 +716,17 @@ namespace transport {
             }
 
             builder.EndDict();
-            responses.push_back(builder.Build());
+            return builder.Build();
         }
 
         svg::Color ParseColor(const json::Node& color_node) {
-            if (color_node.IsArray() && color_node.AsArray().size() == 4) {
-                return svg::Color{
-                    svg::Rgba{
-                        static_cast<uint8_t>(color_node.AsArray().at(0).AsInt()),
-                        static_cast<uint8_t>(color_node.AsArray().at(1).AsInt()),
-                        static_cast<uint8_t>(color_node.AsArray().at(2).AsInt()),
-                        color_node.AsArray().at(3).AsDouble()
-                    }
-                };
-            }
-            else if (color_node.IsArray() && color_node.AsArray().size() == 3) {
-                return svg::Color{
-                    svg::Rgb{
-                        static_cast<uint8_t>(color_node.AsArray().at(0).AsInt()),
-                        static_cast<uint8_t>(color_node.AsArray().at(1).AsInt()),
-                        static_cast<uint8_t>(color_node.AsArray().at(2).AsInt()),
-                    }
-                };
-            }
-            else {
-                return color_node.AsString();
-            }
+            svg::Color color;
+            json::ValueReader<svg::Color>::Read(color_node, color);
+            return color;
         }
 
-
-     
-
         RenderSettings GetRenderSettings(const json::Document& doc) {
-            const auto& render_settings = doc.GetRoot().AsDict().at("render_settings").AsDict();
-            RenderSettings settings;
-
-            settings.width = render_settings.at("width").AsDouble();
-            settings.height = render_settings.at("height").AsDouble();
-            settings.padding = render_settings.at("padding").AsDouble();
-            settings.stop_radius = render_settings.at("stop_radius").AsDouble();
-            settings.line_width = render_settings.at("line_width").AsDouble();
-            settings.bus_label_font_size = render_settings.at("bus_label_font_size").AsInt();
-            settings.bus_label_offset = {
-                render_settings.at("bus_label_offset").AsArray().at(0).AsDouble(),
-                render_settings.at("bus_label_offset").AsArray().at(1).AsDouble()
-            };
-
-            settings.stop_label_font_size = render_settings.at("stop_label_font_size").AsInt();
-            settings.stop_label_offset = {
-                render_settings.at("stop_label_offset").AsArray().at(0).AsDouble(),
-                render_settings.at("stop_label_offset").AsArray().at(1).AsDouble()
-            };
-
-            settings.underlayer_color = ParseColor(render_settings.at("underlayer_color"));
-            settings.underlayer_width = render_settings.at("underlayer_width").AsDouble();
-
-            for (const auto& color_node : render_settings.at("color_palette").AsArray()) {
-                settings.color_palette.push_back(ParseColor(color_node));
-            }
-
-            return settings;
+            return json::Decode<RenderSettings>(doc.GetRoot().AsDict().at("render_settings"));
         }
 
     } // namespace catalogue
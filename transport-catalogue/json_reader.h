@@ -3,11 +3,20 @@
 #pragma once
 
 #include "transport_catalogue.h"
+#include "mapped_catalogue.h"
 #include "json.h"
+#include "json_tape.h"
 #include "json_builder.h"
 #include "svg.h"
 #include "transport_router.h"
 
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 namespace transport {
     namespace catalogue {
 
@@ -24,25 +33,98 @@ namespace transport {
             svg::Color underlayer_color;
             double underlayer_width = 0;
             std::vector<svg::Color> color_palette = {};
+
+            bool operator==(const RenderSettings&) const = default;
+        };
+
+        // Записи base_requests и stat_requests. Строки указывают в разобранный документ
+
+        struct StopRequest {
+            std::string_view name;
+            double latitude = 0.0;
+            double longitude = 0.0;
+            std::unordered_map<std::string, int> road_distances;
+        };
+
+        struct BusRequest {
+            std::string_view name;
+            std::vector<std::string_view> stops;
+            bool is_roundtrip = false;
+        };
+
+        // Запросы Bus и Stop: сведения об объекте по имени
+        struct InfoRequest {
+            int id = 0;
+            std::string_view name;
+        };
+
+        struct MapRequest {
+            int id = 0;
+        };
+
+        struct RouteRequest {
+            int id = 0;
+            std::string_view from;
+            std::string_view to;
         };
 
         svg::Color ParseColor(const json::Node& color_node);
         RenderSettings GetRenderSettings(const json::Document& doc);
+        RoutingSettings GetRoutingSettings(const json::Document& doc);
 
         class JsonReader {
         public:
             JsonReader(TransportCatalogue& tc) : catalogue_(tc) {}
             void LoadData(const json::Document& doc);
-            void ProcessRequests(const json::Document& doc, std::ostream& output);
+            void LoadData(const json::TapeDocument& doc);
+            // Разбирает поток без построения дерева для base_requests: остановки и маршруты
+            // добавляются в справочник во время разбора. Возвращает документ с остальными разделами
+            // Если with_base_requests == false, раздел base_requests пропускается
+            json::Document LoadData(std::istream& input, bool with_base_requests = true);
+
+            // Снимок содержит справочник и маршрутизатор, построенный по routing_settings из doc (если они заданы)
+            void SaveSnapshot(std::ostream& output, const json::Document& doc);
+            // Загружает справочник и маршрутизатор из снимка; справочник должен быть пуст
+            void LoadSnapshot(std::istream& input);
+            // Записывает справочник в формате MappedCatalogue
+            void WriteMappedCatalogue(std::ostream& output) const;
+            // Запросы Bus и Stop обслуживаются из отображённого файла, а не из справочника
+            void SetMappedCatalogue(const MappedCatalogue* mapped_catalogue) { mapped_catalogue_ = mapped_catalogue; }
+            // При thread_count > 1 запросы выполняются параллельно, ответы выводятся в порядке запросов.
+            // Если среди запросов есть Route, маршрутизатор строится в отдельном потоке,
+            // пока обрабатываются остальные запросы
+            void ProcessRequests(const json::Document& doc, std::ostream& output, size_t thread_count = 1);
 
         private:
-            void ProcessBusRequest(const json::Dict& request_map, int request_id, json::Array& responses);
-            void ProcessStopRequest(const json::Dict& request_map, int request_id, json::Array& responses);
-            void ProcessMapRequest(int request_id, const json::Document& doc, json::Array& responses);
-            void ProcessRouteRequest(const json::Dict& request_map, int request_id, json::Array& responses, const json::Document& doc);
+            // Отрисованная карта в виде готовой строки JSON. Действительна, пока не изменились
+            // справочник и настройки отрисовки
+            struct MapCache {
+                uint64_t catalogue_version = 0;
+                RenderSettings settings;
+                std::shared_ptr<const std::string> map_json;
+            };
+
+            // Пишет ответ в writer; возвращает false для запросов неизвестного типа
+            bool ProcessRequest(const json::Dict& request_map, const json::Document& doc, json::Writer& writer);
+            void ProcessRequestsParallel(const json::Array& stat_requests, const json::Document& doc,
+                json::Writer& writer, std::streamsize precision, size_t thread_count);
+            json::Node ProcessBusRequest(const InfoRequest& request);
+            json::Node ProcessStopRequest(const InfoRequest& request);
+            void ProcessMapRequest(int request_id, const json::Document& doc, json::Writer& writer);
+            std::shared_ptr<const std::string> GetMapJson(const json::Document& doc);
+            void StartRouterBuild(const json::Array& stat_requests, const json::Document& doc);
+            const TransportRouter& GetRouter(const json::Document& doc);
+            json::Node ProcessRouteRequest(const RouteRequest& request, const json::Document& doc);
 
             std::optional<TransportRouter> transport_router_;
+            // Готовность маршрутизатора, который строится в фоне; до неё transport_router_ не трогаем
+            std::shared_future<void> router_ready_;
             TransportCatalogue& catalogue_;
+            const MappedCatalogue* mapped_catalogue_ = nullptr;
+            std::optional<MapCache> map_cache_;
+            // Запоминать ли отрисованную карту: имеет смысл, только если запросов Map несколько
+            bool cache_map_ = false;
+            std::mutex map_cache_mutex_;
             const std::string error_message = "not found";
         };
 
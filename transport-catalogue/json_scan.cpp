@@ -0,0 +1,147 @@
+// json_scan.cpp
+
+#include "json_scan.h"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JSON_SCAN_X86 1
+#define JSON_SCAN_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#define JSON_SCAN_X86 1
+#define JSON_SCAN_TARGET(isa)
+#endif
+
+namespace json {
+
+    namespace {
+
+        bool IsStringStop(char c) {
+            return c == '"' || c == '\\' || c == '\n' || c == '\r';
+        }
+
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+        }
+
+        const char* FindStringStopScalar(const char* begin, const char* end) {
+            while (begin != end && !IsStringStop(*begin)) {
+                ++begin;
+            }
+            return begin;
+        }
+
+        const char* SkipSpacesScalar(const char* begin, const char* end) {
+            while (begin != end && IsSpace(*begin)) {
+                ++begin;
+            }
+            return begin;
+        }
+
+#if defined(JSON_SCAN_X86)
+        JSON_SCAN_TARGET("sse2")
+        const char* FindStringStopSse2(const char* begin, const char* end) {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i new_line = _mm_set1_epi8('\n');
+            const __m128i carriage_return = _mm_set1_epi8('\r');
+            for (; end - begin >= 16; begin += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                const __m128i stops = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, new_line), _mm_cmpeq_epi8(chunk, carriage_return)));
+                if (const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(stops)); mask != 0) {
+                    return begin + std::countr_zero(mask);
+                }
+            }
+            return FindStringStopScalar(begin, end);
+        }
+
+        // \t, \n, \v, \f и \r - коды с 9 по 13
+        JSON_SCAN_TARGET("sse2")
+        const char* SkipSpacesSse2(const char* begin, const char* end) {
+            const __m128i space = _mm_set1_epi8(' ');
+            const __m128i control_low = _mm_set1_epi8(8);
+            const __m128i control_high = _mm_set1_epi8(14);
+            for (; end - begin >= 16; begin += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                const __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                    _mm_and_si128(_mm_cmpgt_epi8(chunk, control_low), _mm_cmplt_epi8(chunk, control_high)));
+                if (const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(spaces)) & 0xFFFF; mask != 0) {
+                    return begin + std::countr_zero(mask);
+                }
+            }
+            return SkipSpacesScalar(begin, end);
+        }
+
+        JSON_SCAN_TARGET("avx2,bmi")
+        const char* FindStringStopAvx2(const char* begin, const char* end) {
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i new_line = _mm256_set1_epi8('\n');
+            const __m256i carriage_return = _mm256_set1_epi8('\r');
+            for (; end - begin >= 32; begin += 32) {
+                const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                const __m256i stops = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, new_line), _mm256_cmpeq_epi8(chunk, carriage_return)));
+                if (const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(stops)); mask != 0) {
+                    return begin + std::countr_zero(mask);
+                }
+            }
+            return FindStringStopSse2(begin, end);
+        }
+
+        JSON_SCAN_TARGET("avx2,bmi")
+        const char* SkipSpacesAvx2(const char* begin, const char* end) {
+            const __m256i space = _mm256_set1_epi8(' ');
+            const __m256i control_low = _mm256_set1_epi8(8);
+            const __m256i control_high = _mm256_set1_epi8(14);
+            for (; end - begin >= 32; begin += 32) {
+                const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                const __m256i spaces = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space),
+                    _mm256_and_si256(_mm256_cmpgt_epi8(chunk, control_low), _mm256_cmpgt_epi8(control_high, chunk)));
+                if (const uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(spaces)); mask != 0) {
+                    return begin + std::countr_zero(mask);
+                }
+            }
+            return SkipSpacesSse2(begin, end);
+        }
+#endif
+
+        const Scanner SCALAR_SCANNER{ FindStringStopScalar, SkipSpacesScalar };
+#if defined(JSON_SCAN_X86)
+        const Scanner SSE2_SCANNER{ FindStringStopSse2, SkipSpacesSse2 };
+        const Scanner AVX2_SCANNER{ FindStringStopAvx2, SkipSpacesAvx2 };
+#endif
+
+    }  // namespace
+
+    ScanLevel GetBestScanLevel() {
+#if defined(__GNUC__) && defined(JSON_SCAN_X86)
+        static const ScanLevel level = __builtin_cpu_supports("avx2") ? ScanLevel::AVX2 : ScanLevel::SSE2;
+        return level;
+#elif defined(JSON_SCAN_X86)
+        return ScanLevel::SSE2;
+#else
+        return ScanLevel::SCALAR;
+#endif
+    }
+
+    const Scanner& GetScanner(ScanLevel level) {
+#if defined(JSON_SCAN_X86)
+        if (level == ScanLevel::AVX2 && GetBestScanLevel() == ScanLevel::AVX2) {
+            return AVX2_SCANNER;
+        }
+        if (level != ScanLevel::SCALAR) {
+            return SSE2_SCANNER;
+        }
+#endif
+        (void)level;
+        return SCALAR_SCANNER;
+    }
+
+}  // namespace json
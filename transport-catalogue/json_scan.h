@@ -0,0 +1,76 @@
+// json_scan.h
+
+#pragma once
+
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSON_SCAN_INLINE_SSE2 1
+#endif
+
+namespace json {
+
+    // Набор инструкций, которым просматриваются байты входа
+    enum class ScanLevel {
+        SCALAR,
+        SSE2,
+        AVX2,
+    };
+
+    // Лучший уровень, поддерживаемый процессором, на котором запущена программа
+    ScanLevel GetBestScanLevel();
+
+    /*
+     * Поиск символов, на которых парсеру нужно остановиться. Байты сравниваются
+     * сразу со всеми искомыми символами блоками по 16 (SSE2) или 32 (AVX2) байта,
+     * а позиция первого совпадения берётся из битовой маски. Хвост короче блока
+     * и процессоры без SSE2 обрабатываются побайтно
+     */
+    struct Scanner {
+        // Первый символ ", \, \n или \r либо end
+        const char* (*find_string_stop)(const char* begin, const char* end);
+        // Первый непробельный символ либо end
+        const char* (*skip_spaces)(const char* begin, const char* end);
+    };
+
+    // Функции для заданного уровня; уровень выше поддерживаемого процессором понижается
+    const Scanner& GetScanner(ScanLevel level = GetBestScanLevel());
+
+    /*
+     * Лексемы во входных данных короткие, и косвенный вызов через Scanner стоит дороже
+     * самого просмотра. Поэтому первые 16 байт проверяются на месте, а к scanner
+     * обращаемся только для длинных участков
+     */
+    inline const char* FindStringStop(const char* begin, const char* end, const Scanner& scanner) {
+#if defined(JSON_SCAN_INLINE_SSE2)
+        if (end - begin >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const __m128i stops = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+            if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(stops)); mask != 0) {
+                return begin + std::countr_zero(mask);
+            }
+            begin += 16;
+        }
+#endif
+        return scanner.find_string_stop(begin, end);
+    }
+
+    inline const char* SkipSpaces(const char* begin, const char* end, const Scanner& scanner) {
+#if defined(JSON_SCAN_INLINE_SSE2)
+        if (end - begin >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(8)), _mm_cmplt_epi8(chunk, _mm_set1_epi8(14))));
+            if (const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xFFFF; mask != 0) {
+                return begin + std::countr_zero(mask);
+            }
+            begin += 16;
+        }
+#endif
+        return scanner.skip_spaces(begin, end);
+    }
+
+}  // namespace json
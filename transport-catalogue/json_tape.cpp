@@ -0,0 +1,244 @@
+// json_tape.cpp
+
+#include "json_tape.h"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace json {
+
+    using namespace std::literals;
+
+    bool TapeNode::IsNull() const {
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::NUL;
+    }
+
+    bool TapeNode::IsBool() const {
+        const auto tag = document_->GetEntry(index_).tag;
+        return tag == TapeDocument::Tag::BOOL_TRUE || tag == TapeDocument::Tag::BOOL_FALSE;
+    }
+
+    bool TapeNode::IsInt() const {
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::INT;
+    }
+
+    bool TapeNode::IsPureDouble() const {
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::DOUBLE;
+    }
+
+    bool TapeNode::IsDouble() const {
+        return IsInt() || IsPureDouble();
+    }
+
+    bool TapeNode::IsString() const {
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::STRING;
+    }
+
+    bool TapeNode::IsArray() const {
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::ARRAY;
+    }
+
+    bool TapeNode::IsDict() const {
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::DICT;
+    }
+
+    bool TapeNode::AsBool() const {
+        if (!IsBool()) {
+            throw std::logic_error("Not a bool"s);
+        }
+        return document_->GetEntry(index_).tag == TapeDocument::Tag::BOOL_TRUE;
+    }
+
+    int TapeNode::AsInt() const {
+        if (!IsInt()) {
+            throw std::logic_error("Not an int"s);
+        }
+        return document_->GetEntry(index_).int_value;
+    }
+
+    double TapeNode::AsDouble() const {
+        if (!IsDouble()) {
+            throw std::logic_error("Not a double"s);
+        }
+        const auto& entry = document_->GetEntry(index_);
+        return entry.tag == TapeDocument::Tag::DOUBLE ? entry.double_value : entry.int_value;
+    }
+
+    std::string_view TapeNode::AsString() const {
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+        return document_->GetString(document_->GetEntry(index_));
+    }
+
+    TapeArray TapeNode::AsArray() const {
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+        return TapeArray(*this);
+    }
+
+    TapeDict TapeNode::AsDict() const {
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+        return TapeDict(*this);
+    }
+
+    TapeArray::Iterator& TapeArray::Iterator::operator++() {
+        index_ = document_->Skip(index_);
+        return *this;
+    }
+
+    TapeArray::Iterator TapeArray::begin() const {
+        return { document_, index_ + 1 };
+    }
+
+    TapeArray::Iterator TapeArray::end() const {
+        return { document_, document_->Skip(index_) };
+    }
+
+    size_t TapeArray::size() const {
+        return document_->GetEntry(index_).size;
+    }
+
+    TapeDict::Iterator::value_type TapeDict::Iterator::operator*() const {
+        return { document_->GetString(document_->GetEntry(index_)), TapeNode(document_, index_ + 1) };
+    }
+
+    TapeDict::Iterator& TapeDict::Iterator::operator++() {
+        index_ = document_->Skip(index_ + 1);
+        return *this;
+    }
+
+    TapeDict::Iterator TapeDict::begin() const {
+        return { document_, index_ + 1 };
+    }
+
+    TapeDict::Iterator TapeDict::end() const {
+        return { document_, document_->Skip(index_) };
+    }
+
+    TapeDict::Iterator TapeDict::find(std::string_view key) const {
+        const auto last = end();
+        for (auto it = begin(); it != last; ++it) {
+            if ((*it).first == key) {
+                return it;
+            }
+        }
+        return last;
+    }
+
+    TapeNode TapeDict::at(std::string_view key) const {
+        const auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
+        }
+        return (*it).second;
+    }
+
+    size_t TapeDict::size() const {
+        return document_->GetEntry(index_).size;
+    }
+
+    // Запись приходится примерно на каждые 13 байт входа, а строки не длиннее самого входа
+    TapeHandler::TapeHandler(size_t input_size) {
+        document_.tape_.reserve(input_size / 8 + 1);
+        document_.strings_.reserve(input_size);
+    }
+
+    void TapeHandler::Null() {
+        AddValue(TapeDocument::Tag::NUL);
+    }
+
+    void TapeHandler::Bool(bool value) {
+        AddValue(value ? TapeDocument::Tag::BOOL_TRUE : TapeDocument::Tag::BOOL_FALSE);
+    }
+
+    void TapeHandler::Int(int value) {
+        AddValue(TapeDocument::Tag::INT).int_value = value;
+    }
+
+    void TapeHandler::Double(double value) {
+        AddValue(TapeDocument::Tag::DOUBLE).double_value = value;
+    }
+
+    void TapeHandler::String(std::string_view value) {
+        AddString(value);
+    }
+
+    void TapeHandler::StartArray() {
+        AddValue(TapeDocument::Tag::ARRAY);
+        open_.push_back(static_cast<uint32_t>(document_.tape_.size() - 1));
+    }
+
+    void TapeHandler::EndArray() {
+        CloseContainer();
+    }
+
+    void TapeHandler::StartDict() {
+        AddValue(TapeDocument::Tag::DICT);
+        open_.push_back(static_cast<uint32_t>(document_.tape_.size() - 1));
+    }
+
+    // Ключ записывается как строка перед своим значением
+    void TapeHandler::Key(std::string_view key) {
+        // словарь ещё не закрыт, поэтому его пары просматриваются до конца ленты
+        const TapeDict::Iterator last(&document_, static_cast<uint32_t>(document_.tape_.size()));
+        for (TapeDict::Iterator it(&document_, open_.back() + 1); it != last; ++it) {
+            if ((*it).first == key) {
+                throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+            }
+        }
+        ++document_.tape_[open_.back()].size;
+        AddString(key);
+    }
+
+    void TapeHandler::EndDict() {
+        CloseContainer();
+    }
+
+    TapeDocument TapeHandler::Extract() {
+        return std::move(document_);
+    }
+
+    TapeDocument::Entry& TapeHandler::AddValue(TapeDocument::Tag tag) {
+        if (!open_.empty()) {
+            auto& parent = document_.tape_[open_.back()];
+            if (parent.tag == TapeDocument::Tag::ARRAY) {
+                ++parent.size;
+            }
+        }
+        auto& entry = document_.tape_.emplace_back();
+        entry.tag = tag;
+        entry.size = 0;
+        entry.next = 0;
+        return entry;
+    }
+
+    // Для ключа AddValue не меняет размер словаря: пары считает Key
+    void TapeHandler::AddString(std::string_view value) {
+        const auto offset = document_.strings_.size();
+        document_.strings_ += value;
+        auto& entry = AddValue(TapeDocument::Tag::STRING);
+        entry.size = static_cast<uint32_t>(value.size());
+        entry.offset = offset;
+    }
+
+    void TapeHandler::CloseContainer() {
+        document_.tape_[open_.back()].next = document_.tape_.size();
+        open_.pop_back();
+    }
+
+    TapeDocument LoadTape(std::string_view input) {
+        TapeHandler handler(input.size());
+        Parse(input, handler);
+        return handler.Extract();
+    }
+
+    TapeDocument LoadTape(std::istream& input) {
+        std::string buffer(std::istreambuf_iterator<char>(input), {});
+        return LoadTape(std::string_view(buffer));
+    }
+
+}  // namespace json
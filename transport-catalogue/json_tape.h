@@ -0,0 +1,258 @@
+// json_tape.h
+
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+    class TapeDocument;
+    class TapeArray;
+    class TapeDict;
+
+    // Лёгкая ссылка на узел ленты; действительна, пока жив и не перемещён документ
+    class TapeNode {
+    public:
+        TapeNode(const TapeDocument* document, uint32_t index)
+            : document_(document), index_(index) {
+        }
+
+        bool IsNull() const;
+        bool IsBool() const;
+        bool IsInt() const;
+        bool IsPureDouble() const;
+        bool IsDouble() const;
+        bool IsString() const;
+        bool IsArray() const;
+        bool IsDict() const;
+
+        bool AsBool() const;
+        int AsInt() const;
+        double AsDouble() const;
+        std::string_view AsString() const;
+        TapeArray AsArray() const;
+        TapeDict AsDict() const;
+
+    private:
+        friend class TapeArray;
+        friend class TapeDict;
+
+        const TapeDocument* document_;
+        uint32_t index_;
+    };
+
+    // Элементы массива; интерфейс повторяет нужную часть std::vector
+    class TapeArray {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = TapeNode;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = TapeNode;
+
+            Iterator(const TapeDocument* document, uint32_t index)
+                : document_(document), index_(index) {
+            }
+
+            TapeNode operator*() const {
+                return { document_, index_ };
+            }
+            Iterator& operator++();
+            Iterator operator++(int) {
+                Iterator prev = *this;
+                ++*this;
+                return prev;
+            }
+            bool operator==(const Iterator& rhs) const {
+                return index_ == rhs.index_;
+            }
+            bool operator!=(const Iterator& rhs) const {
+                return index_ != rhs.index_;
+            }
+
+        private:
+            const TapeDocument* document_;
+            uint32_t index_;
+        };
+
+        explicit TapeArray(const TapeNode& node)
+            : document_(node.document_), index_(node.index_) {
+        }
+
+        Iterator begin() const;
+        Iterator end() const;
+        size_t size() const;
+        bool empty() const {
+            return size() == 0;
+        }
+
+    private:
+        const TapeDocument* document_;
+        uint32_t index_;
+    };
+
+    // Пары ключ-значение словаря в порядке документа; интерфейс повторяет нужную часть std::map.
+    // Поиск по ключу линейный: словари во входных данных небольшие
+    class TapeDict {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<std::string_view, TapeNode>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            Iterator(const TapeDocument* document, uint32_t index)
+                : document_(document), index_(index) {
+            }
+
+            value_type operator*() const;
+            Iterator& operator++();
+            Iterator operator++(int) {
+                Iterator prev = *this;
+                ++*this;
+                return prev;
+            }
+            bool operator==(const Iterator& rhs) const {
+                return index_ == rhs.index_;
+            }
+            bool operator!=(const Iterator& rhs) const {
+                return index_ != rhs.index_;
+            }
+
+        private:
+            const TapeDocument* document_;
+            uint32_t index_; // запись ключа
+        };
+
+        explicit TapeDict(const TapeNode& node)
+            : document_(node.document_), index_(node.index_) {
+        }
+
+        Iterator begin() const;
+        Iterator end() const;
+        Iterator find(std::string_view key) const;
+        // Бросает std::out_of_range, если ключа нет
+        TapeNode at(std::string_view key) const;
+        size_t size() const;
+        bool empty() const {
+            return size() == 0;
+        }
+
+    private:
+        const TapeDocument* document_;
+        uint32_t index_;
+    };
+
+    /*
+     * Документ в виде ленты: узлы записаны подряд в порядке обхода, по одной 16-байтной записи
+     * на значение или ключ. Запись контейнера хранит число элементов и индекс записи за его концом,
+     * поэтому вложенные значения пропускаются без обхода. Все строки лежат в одном буфере,
+     * а запись строки хранит смещение и длину. Узлы не владеют памятью, и отдельных
+     * выделений на каждый узел, ключ или строку нет
+     */
+    class TapeDocument {
+    public:
+        TapeNode GetRoot() const {
+            return { this, 0 };
+        }
+
+        size_t GetEntryCount() const {
+            return tape_.size();
+        }
+        // Байты, занятые лентой и буфером строк
+        size_t GetMemoryUsage() const {
+            return tape_.capacity() * sizeof(Entry) + strings_.capacity();
+        }
+
+    private:
+        friend class TapeHandler;
+        friend class TapeNode;
+        friend class TapeArray;
+        friend class TapeDict;
+
+        enum class Tag : uint8_t {
+            NUL,
+            BOOL_FALSE,
+            BOOL_TRUE,
+            INT,
+            DOUBLE,
+            STRING,
+            ARRAY,
+            DICT,
+        };
+
+        struct Entry {
+            Tag tag;
+            uint32_t size;  // длина строки или число элементов контейнера (пар для словаря)
+            union {
+                int int_value;
+                double double_value;
+                uint64_t offset; // начало строки в strings_
+                uint64_t next;   // индекс записи за концом контейнера
+            };
+        };
+        static_assert(sizeof(Entry) == 16);
+
+        const Entry& GetEntry(uint32_t index) const {
+            return tape_[index];
+        }
+        // Индекс записи, следующей за значением index вместе с его содержимым
+        uint32_t Skip(uint32_t index) const {
+            const Entry& entry = tape_[index];
+            return entry.tag == Tag::ARRAY || entry.tag == Tag::DICT ? static_cast<uint32_t>(entry.next) : index + 1;
+        }
+        std::string_view GetString(const Entry& entry) const {
+            return { strings_.data() + entry.offset, entry.size };
+        }
+
+        std::vector<Entry> tape_;
+        std::string strings_;
+    };
+
+    // Обработчик, записывающий события разбора в ленту
+    class TapeHandler final : public Handler {
+    public:
+        TapeHandler() = default;
+        // Резервирует ленту и буфер строк под документ такого размера, чтобы не копировать их при росте
+        explicit TapeHandler(size_t input_size);
+
+        void Null() override;
+        void Bool(bool value) override;
+        void Int(int value) override;
+        void Double(double value) override;
+        void String(std::string_view value) override;
+
+        void StartArray() override;
+        void EndArray() override;
+        void StartDict() override;
+        void Key(std::string_view key) override;
+        void EndDict() override;
+
+        TapeDocument Extract();
+
+    private:
+        TapeDocument::Entry& AddValue(TapeDocument::Tag tag);
+        void AddString(std::string_view value);
+        void CloseContainer();
+
+        TapeDocument document_;
+        std::vector<uint32_t> open_; // индексы записей незакрытых контейнеров
+    };
+
+    // Разбирает документ из буфера в памяти в ленту
+    TapeDocument LoadTape(std::string_view input);
+    // Читает поток до конца и разбирает прочитанное в ленту
+    TapeDocument LoadTape(std::istream& input);
+
+}  // namespace json
@@ -2,26 +2,139 @@
 #include "json.h"
 #include "json_reader.h"
 #include "map_renderer.h"
-#include "log_duration.h"
+#include "mapped_catalogue.h"
+#include "profiler.h"
 
-int main() {
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    struct Options {
+        size_t thread_count = 1;     // --threads N: число потоков для выполнения stat_requests
+        std::string save_snapshot;   // --save-snapshot FILE: сохранить построенный справочник и маршрутизатор
+        std::string load_snapshot;   // --load-snapshot FILE: взять их из снимка вместо base_requests
+        std::string write_mapped;    // --write-mapped-catalogue FILE: записать справочник для отображения в память
+        std::string map_catalogue;   // --map-catalogue FILE: отвечать на Bus и Stop из отображённого файла
+        bool profile = false;        // --profile: вывести в stderr сводку замеров времени при выходе
+        std::string trace;           // --trace FILE: записать при выходе замеры в формате Chrome Trace Event
+    };
+
+    Options ParseOptions(int argc, char** argv) {
+        using namespace std::literals;
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            if (argv[i] == "--threads"sv && i + 1 < argc) {
+                options.thread_count = std::strtoul(argv[++i], nullptr, 10);
+            }
+            else if (argv[i] == "--save-snapshot"sv && i + 1 < argc) {
+                options.save_snapshot = argv[++i];
+            }
+            else if (argv[i] == "--load-snapshot"sv && i + 1 < argc) {
+                options.load_snapshot = argv[++i];
+            }
+            else if (argv[i] == "--write-mapped-catalogue"sv && i + 1 < argc) {
+                options.write_mapped = argv[++i];
+            }
+            else if (argv[i] == "--map-catalogue"sv && i + 1 < argc) {
+                options.map_catalogue = argv[++i];
+            }
+            else if (argv[i] == "--profile"sv) {
+                options.profile = true;
+            }
+            else if (argv[i] == "--trace"sv && i + 1 < argc) {
+                options.trace = argv[++i];
+            }
+            else {
+                throw std::invalid_argument("Unknown argument: "s + argv[i]);
+            }
+        }
+        if (options.thread_count == 0) {
+            options.thread_count = 1;
+        }
+        return options;
+    }
+
+    // Без --load-snapshot справочник в памяти пуст, и ответы на Route и Map были бы неверными
+    void CheckMappedOnlyRequests(const json::Document& doc) {
+        using namespace std::literals;
+        const auto& sections = doc.GetRoot().AsDict();
+        const auto stat_requests = sections.find("stat_requests"sv);
+        if (stat_requests == sections.end()) {
+            return;
+        }
+        for (const auto& request : stat_requests->second.AsArray()) {
+            const std::string& type = request.AsDict().at("type"s).AsString();
+            if (type == "Route"sv || type == "Map"sv) {
+                throw std::invalid_argument(type + " requests need --load-snapshot together with --map-catalogue"s);
+            }
+        }
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
     try {
-        LOG_DURATION("Program");
         using namespace transport::catalogue;
 
-        json::Document input_doc = json::Load(std::cin);
+        const Options options = ParseOptions(argc, argv);
+        profiler::SetEnabled(options.profile);
+        if (!options.trace.empty()) {
+            profiler::EnableTracing(options.trace);
+        }
+        PROFILE_SCOPE("Program");
 
         TransportCatalogue catalogue;
 
         JsonReader json_reader(catalogue);
 
-        json_reader.LoadData(input_doc);
-        
-        
-        json_reader.ProcessRequests(input_doc, std::cout);
+        if (!options.load_snapshot.empty()) {
+            std::ifstream snapshot(options.load_snapshot, std::ios::binary);
+            if (!snapshot) {
+                throw std::runtime_error("Can't open snapshot " + options.load_snapshot);
+            }
+            json_reader.LoadSnapshot(snapshot);
+        }
+
+        // Route и Map по-прежнему требуют справочника, поэтому вместе с --map-catalogue их обслуживает только --load-snapshot;
+        // без него такие запросы отвергаются до вывода ответов
+        std::optional<MappedCatalogue> mapped_catalogue;
+        if (!options.map_catalogue.empty()) {
+            mapped_catalogue.emplace(options.map_catalogue);
+            json_reader.SetMappedCatalogue(&mapped_catalogue.value());
+        }
+
+        const bool with_base_requests = options.load_snapshot.empty() && options.map_catalogue.empty();
+        json::Document input_doc = json_reader.LoadData(std::cin, with_base_requests);
+        if (mapped_catalogue && options.load_snapshot.empty()) {
+            CheckMappedOnlyRequests(input_doc);
+        }
+
+        if (!options.write_mapped.empty()) {
+            std::ofstream mapped(options.write_mapped, std::ios::binary);
+            json_reader.WriteMappedCatalogue(mapped);
+            if (!mapped) {
+                throw std::runtime_error("Can't write mapped catalogue " + options.write_mapped);
+            }
+        }
 
-    
+        if (!options.save_snapshot.empty()) {
+            std::ofstream snapshot(options.save_snapshot, std::ios::binary);
+            json_reader.SaveSnapshot(snapshot, input_doc);
+            if (!snapshot) {
+                throw std::runtime_error("Can't write snapshot " + options.save_snapshot);
+            }
+        }
 
+        // при сохранении снимка запросов к справочнику может и не быть
+        const auto& sections = input_doc.GetRoot().AsDict();
+        const bool only_saving = !options.save_snapshot.empty() || !options.write_mapped.empty();
+        if (!only_saving || sections.find("stat_requests") != sections.end()) {
+            json_reader.ProcessRequests(input_doc, std::cout, options.thread_count);
+        }
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
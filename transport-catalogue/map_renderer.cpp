@@ -66,145 +66,160 @@ namespace transport {
 
         MapRenderer::MapRenderer(RenderSettings settings) : settings_(std::move(settings)) {}
 
-        void MapRenderer::DrawRouteLines(svg::Document& doc, const std::map<std::string_view, BusRoute*>& buses, const std::map<std::string_view, Stop*>& stops, const SphereProjector& projector, size_t& color_index) const {
+        MapRenderer::MapStyles MapRenderer::AddStyles(svg::CompactDocument& doc) const {
+            // Стиль только с заливкой; остальные атрибуты не выводятся
+            auto fill_style = [](svg::Color color) {
+                svg::PathStyle style;
+                style.fill_color = std::move(color);
+                return style;
+            };
+
+            MapStyles styles;
+            for (const svg::Color& color : settings_.color_palette) {
+                styles.route_lines.push_back(doc.AddStyle({
+                    .fill_color = svg::NoneColor,
+                    .stroke_color = color,
+                    .stroke_width = settings_.line_width,
+                    .stroke_line_cap = svg::StrokeLineCap::ROUND,
+                    .stroke_line_join = svg::StrokeLineJoin::ROUND,
+                }));
+                styles.route_names.push_back(doc.AddStyle(fill_style(color)));
+            }
+            styles.underlayer = doc.AddStyle({
+                .fill_color = settings_.underlayer_color,
+                .stroke_color = settings_.underlayer_color,
+                .stroke_width = settings_.underlayer_width,
+                .stroke_line_cap = svg::StrokeLineCap::ROUND,
+                .stroke_line_join = svg::StrokeLineJoin::ROUND,
+            });
+            styles.stop_circle = doc.AddStyle(fill_style("white"));
+            styles.stop_name = doc.AddStyle(fill_style("black"));
+            styles.bus_label_font = doc.AddFont({ static_cast<uint32_t>(settings_.bus_label_font_size), "Verdana", "bold" });
+            styles.stop_label_font = doc.AddFont({ static_cast<uint32_t>(settings_.stop_label_font_size), "Verdana", "" });
+            return styles;
+        }
+
+        void MapRenderer::DrawRouteLines(svg::CompactDocument& doc, const MapStyles& styles, const std::vector<std::pair<std::string_view, BusRoute*>>& buses, const TransportCatalogue& catalogue, const SphereProjector& projector, size_t& color_index) const {
             for (const auto& [_, bus] : buses) {
-                svg::Polyline polyline;
-                polyline.SetStrokeColor(settings_.color_palette[color_index])
-                    .SetFillColor(svg::NoneColor)
-                    .SetStrokeWidth(settings_.line_width)
-                    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-
-                const auto bus_stops = bus->stops;
-
-                for (const auto& stop_name : bus_stops) {
-                    const auto& stop = stops.find(stop_name);
-                    polyline.AddPoint(projector(stop->second->coordinates));
+                doc.StartPolyline(styles.route_lines.at(color_index));
+
+                const auto& bus_stops = bus->stops;
+
+                for (const StopId stop_id : bus_stops) {
+                    doc.AddPoint(projector(catalogue.GetStop(stop_id).coordinates));
                 }
 
                 if (!bus->is_circular) {
-                    std::vector<std::string> bus_stops_reversed = { bus_stops.rbegin() + 1, bus_stops.rend() };
-                    for (const auto& stop_name : bus_stops_reversed) {
-                        const auto& stop = stops.find(stop_name);
-                        polyline.AddPoint(projector(stop->second->coordinates));
+                    for (auto it = bus_stops.rbegin() + 1; it != bus_stops.rend(); ++it) {
+                        doc.AddPoint(projector(catalogue.GetStop(*it).coordinates));
                     }
                 }
-                doc.Add(std::move(polyline));
                 color_index = (color_index + 1) % settings_.color_palette.size();
             }
         }
 
-        void MapRenderer::DrawRouteNames(svg::Document& doc, const std::map<std::string_view, BusRoute*>& buses, const std::map<std::string_view, Stop*>& stops, const SphereProjector& projector, size_t& color_index) const {
+        // Подложка и надпись ссылаются на один и тот же текст в документе
+        void MapRenderer::DrawRouteNames(svg::CompactDocument& doc, const MapStyles& styles, const std::vector<std::pair<std::string_view, BusRoute*>>& buses, const TransportCatalogue& catalogue, const SphereProjector& projector, size_t& color_index) const {
+            const svg::Point offset{ settings_.bus_label_offset.first, settings_.bus_label_offset.second };
 
             for (const auto& [_, bus] : buses) {
                 const auto& bus_stops = bus->stops;
-                const auto& start_stop = stops.find(bus_stops.front());
-                const auto& end_stop = stops.find(bus_stops.back());
-
-                svg::Text text;
-                text.SetFillColor(settings_.color_palette.at(color_index))
-                    .SetPosition(projector(start_stop->second->coordinates))
-                    .SetOffset({ settings_.bus_label_offset.first, settings_.bus_label_offset.second })
-                    .SetFontSize(settings_.bus_label_font_size)
-                    .SetFontFamily("Verdana")
-                    .SetFontWeight("bold")
-                    .SetData(std::string(bus->name));
-
-                svg::Text underlayer = text;
-                underlayer.SetFillColor(settings_.underlayer_color)
-                    .SetStrokeColor(settings_.underlayer_color)
-                    .SetStrokeWidth(settings_.underlayer_width)
-                    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-
-                doc.Add(underlayer);
-                doc.Add(text);
+                const Stop& start_stop = catalogue.GetStop(bus_stops.front());
+                const Stop& end_stop = catalogue.GetStop(bus_stops.back());
+
+                const auto text_style = styles.route_names.at(color_index);
+                const auto name = doc.AddString(bus->name);
+
+                const svg::Point start = projector(start_stop.coordinates);
+                doc.AddText(styles.underlayer, styles.bus_label_font, start, offset, name);
+                doc.AddText(text_style, styles.bus_label_font, start, offset, name);
 
                 if (!bus->is_circular && bus_stops.front() != bus_stops.back()) {
-                    svg::Text end_text = text;
-                    end_text.SetPosition(projector(end_stop->second->coordinates));
-                    svg::Text end_underlayer = end_text;
-                    end_underlayer.SetFillColor(settings_.underlayer_color)
-                        .SetStrokeColor(settings_.underlayer_color)
-                        .SetStrokeWidth(settings_.underlayer_width)
-                        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-
-                    doc.Add(end_underlayer);
-                    doc.Add(end_text);
+                    const svg::Point end = projector(end_stop.coordinates);
+                    doc.AddText(styles.underlayer, styles.bus_label_font, end, offset, name);
+                    doc.AddText(text_style, styles.bus_label_font, end, offset, name);
                 }
                 color_index = (color_index + 1) % settings_.color_palette.size();
             }
         }
 
-        void MapRenderer::DrawStops(svg::Document& doc, const std::set<std::string_view>& stops_set, const std::map<std::string_view, Stop*>& stops, const SphereProjector& projector) const {
+        void MapRenderer::DrawStops(svg::CompactDocument& doc, const MapStyles& styles, const std::vector<StopId>& stops, const TransportCatalogue& catalogue, const SphereProjector& projector) const {
             // нарисовать кружочки
-            for (const auto& stop : stops_set) {
-                const auto stop_point = stops.find(stop);
-                svg::Circle circle;
-                circle.SetCenter(projector(stop_point->second->coordinates))
-                    .SetRadius(settings_.stop_radius)
-                    .SetFillColor("white");
-                doc.Add(circle);
+            for (const StopId stop_id : stops) {
+                doc.AddCircle(styles.stop_circle, projector(catalogue.GetStop(stop_id).coordinates), settings_.stop_radius);
             }
             // вывести названия остановок
-            for (const auto& stop : stops_set) {
-                const auto stop_point = stops.find(stop);
-                svg::Text stop_name;
-                stop_name.SetPosition(projector(stop_point->second->coordinates))
-                    .SetOffset({ settings_.stop_label_offset.first, settings_.stop_label_offset.second })
-                    .SetFontSize(settings_.stop_label_font_size)
-                    .SetFontFamily("Verdana")
-                    .SetData(std::string(stop_point->second->name))
-                    .SetFillColor("black");
-
-                svg::Text underlayer = stop_name;
-                underlayer.SetFillColor(settings_.underlayer_color)
-                    .SetStrokeColor(settings_.underlayer_color)
-                    .SetStrokeWidth(settings_.underlayer_width)
-                    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-
-                doc.Add(underlayer);
-                doc.Add(stop_name);
+            const svg::Point offset{ settings_.stop_label_offset.first, settings_.stop_label_offset.second };
+            for (const StopId stop_id : stops) {
+                const Stop& stop = catalogue.GetStop(stop_id);
+                const svg::Point position = projector(stop.coordinates);
+                const auto name = doc.AddString(stop.name);
+                doc.AddText(styles.underlayer, styles.stop_label_font, position, offset, name);
+                doc.AddText(styles.stop_name, styles.stop_label_font, position, offset, name);
             }
 
         }
 
-        void MapRenderer::RenderMap(TransportCatalogue& transport_catalogue,
+        void MapRenderer::RenderMap(const TransportCatalogue& transport_catalogue,
             std::ostream& output) const {
+            svg::CompactDocument doc;
+            DrawMap(doc, transport_catalogue);
+            doc.Render(output);
+        }
 
-            const auto allbuses = transport_catalogue.GetAllBuses();
-            const std::map<std::string_view, BusRoute*>& buses = { allbuses.begin(), allbuses.end() };
-
-            const auto allstops = transport_catalogue.GetAllStops();
-            const std::map<std::string_view, Stop*> stops = { allstops.begin(), allstops.end() };
+        void MapRenderer::StreamMap(const TransportCatalogue& transport_catalogue, std::ostream& output) const {
+            svg::CompactDocument doc(output);
+            DrawMap(doc, transport_catalogue);
+            doc.Finish();
+        }
 
-            svg::Document doc;
+        void MapRenderer::DrawMap(svg::CompactDocument& doc, const TransportCatalogue& transport_catalogue) const {
 
-            std::vector<geo::Coordinates> coords;
-
-            std::set<std::string_view> stops_set;
+            const auto& all_buses = transport_catalogue.GetAllBuses();
+            std::vector<std::pair<std::string_view, BusRoute*>> buses(all_buses.begin(), all_buses.end());
+            std::sort(buses.begin(), buses.end());
 
+            // задать масштаб карты и собрать все используемые остановки
+            size_t stop_count = 0;
+            for (const auto& [_, bus] : buses) {
+                stop_count += bus->stops.size();
+            }
+            std::vector<StopId> stops;
+            stops.reserve(stop_count);
+            for (const auto& [_, bus] : buses) {
+                stops.insert(stops.end(), bus->stops.begin(), bus->stops.end());
+            }
+            std::sort(stops.begin(), stops.end(), [&transport_catalogue](StopId lhs, StopId rhs) {
+                return transport_catalogue.GetStop(lhs).name < transport_catalogue.GetStop(rhs).name;
+            });
+            stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
 
-            // задать масштаб карты и добавить в set все используемые остановки
-            for (const auto& bus : buses) {
-                for (const auto& stop_name : bus.second->stops) {
-                    coords.push_back(transport_catalogue.FindStop(stop_name)->coordinates);
-                    stops_set.insert(transport_catalogue.FindStop(stop_name)->name);
-                }
+            // Крайние точки не зависят от того, сколько раз остановка встречается в маршрутах
+            std::vector<geo::Coordinates> coords;
+            coords.reserve(stops.size());
+            for (const StopId stop_id : stops) {
+                coords.push_back(transport_catalogue.GetStop(stop_id).coordinates);
             }
 
             SphereProjector projector(coords.begin(), coords.end(), settings_.width, settings_.height, settings_.padding);
 
-            size_t color_index = 0;
+            // Ломаная и до четырёх надписей на маршрут, кружок и две надписи на остановку;
+            // вершин ломаных не больше чем вдвое больше остановок маршрутов
+            size_t text_size = 0;
+            for (const auto& [name, _] : buses) {
+                text_size += name.size();
+            }
+            for (const StopId stop_id : stops) {
+                text_size += transport_catalogue.GetStop(stop_id).name.size();
+            }
+            doc.Reserve(5 * buses.size() + 3 * stops.size(), 2 * stop_count, text_size);
+            const MapStyles styles = AddStyles(doc);
 
-            DrawRouteLines(doc, buses, stops, projector, color_index); color_index = 0;
-            DrawRouteNames(doc, buses, stops, projector, color_index);
-            DrawStops(doc, stops_set, stops, projector);
-            
+            size_t color_index = 0;
 
-            doc.Render(output);
+            DrawRouteLines(doc, styles, buses, transport_catalogue, projector, color_index); color_index = 0;
+            DrawRouteNames(doc, styles, buses, transport_catalogue, projector, color_index);
+            DrawStops(doc, styles, stops, transport_catalogue, projector);
         }
 
 
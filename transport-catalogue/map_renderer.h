@@ -2,6 +2,7 @@
 #pragma once
 
 #include "svg.h"
+#include "svg_compact.h"
 #include "geo.h"
 #include "json.h"
 #include "json_reader.h"
@@ -45,13 +46,30 @@ namespace transport {
             
            
             void RenderMap(
-                TransportCatalogue& transport_catalogue,
+                const TransportCatalogue& transport_catalogue,
                 std::ostream& output) const;
+            //    ,   RenderMap,      output ,
+            //       
+            void StreamMap(const TransportCatalogue& transport_catalogue, std::ostream& output) const;
 
         private:
-            void DrawRouteLines(svg::Document& doc, const std::map<std::string_view, BusRoute*>& buses, const std::map<std::string_view, Stop*>& stops, const SphereProjector& projector, size_t& color_index) const;
-            void DrawRouteNames(svg::Document& doc, const std::map<std::string_view, BusRoute*>& buses, const std::map<std::string_view, Stop*>& stops, const SphereProjector& projector, size_t& color_index) const;
-            void DrawStops(svg::Document& doc, const std::set<std::string_view>& stops_set, const std::map<std::string_view, Stop*>& stops, const SphereProjector& projector) const;
+            //    ,   
+            struct MapStyles {
+                std::vector<svg::CompactDocument::StyleId> route_lines;  //   
+                std::vector<svg::CompactDocument::StyleId> route_names;  //   
+                svg::CompactDocument::StyleId underlayer = 0;
+                svg::CompactDocument::StyleId stop_circle = 0;
+                svg::CompactDocument::StyleId stop_name = 0;
+                svg::CompactDocument::FontId bus_label_font = 0;
+                svg::CompactDocument::FontId stop_label_font = 0;
+            };
+
+            void DrawMap(svg::CompactDocument& doc, const TransportCatalogue& transport_catalogue) const;
+            MapStyles AddStyles(svg::CompactDocument& doc) const;
+            //       
+            void DrawRouteLines(svg::CompactDocument& doc, const MapStyles& styles, const std::vector<std::pair<std::string_view, BusRoute*>>& buses, const TransportCatalogue& catalogue, const SphereProjector& projector, size_t& color_index) const;
+            void DrawRouteNames(svg::CompactDocument& doc, const MapStyles& styles, const std::vector<std::pair<std::string_view, BusRoute*>>& buses, const TransportCatalogue& catalogue, const SphereProjector& projector, size_t& color_index) const;
+            void DrawStops(svg::CompactDocument& doc, const MapStyles& styles, const std::vector<StopId>& stops, const TransportCatalogue& catalogue, const SphereProjector& projector) const;
              RenderSettings settings_;
         };
 
@@ -0,0 +1,388 @@
+// mapped_catalogue.cpp
+
+#include "mapped_catalogue.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace transport {
+    namespace catalogue {
+
+        namespace {
+            constexpr char MAGIC[8] = { 'T', 'C', 'M', 'A', 'P', 'P', 'E', 'D' };
+            constexpr size_t SECTION_ALIGNMENT = 8;
+        }
+
+        void MappedCatalogue::Write(std::ostream& output, const TransportCatalogue& catalogue) {
+            static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<StopRecord>
+                && std::is_trivially_copyable_v<BusRecord> && std::is_trivially_copyable_v<DistanceRecord>);
+
+            const auto stop_count = static_cast<uint32_t>(catalogue.GetStopCount());
+            const auto bus_count = static_cast<uint32_t>(catalogue.GetBusCount());
+
+            std::string strings;
+            auto add_string = [&strings](std::string_view value) {
+                const StringRef ref{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size()) };
+                strings += value;
+                return ref;
+            };
+
+            // Расстояния группируются по начальной остановке
+            std::vector<std::vector<DistanceRecord>> distances_by_stop(stop_count);
+            catalogue.ForEachDistance([&distances_by_stop](const Stop& from, const Stop& to, int distance) {
+                distances_by_stop[from.id].push_back({ to.id, distance });
+            });
+
+            std::vector<BusId> buses_by_name(bus_count);
+            for (BusId id = 0; id < bus_count; ++id) {
+                buses_by_name[id] = id;
+            }
+            std::sort(buses_by_name.begin(), buses_by_name.end(), [&catalogue](BusId lhs, BusId rhs) {
+                return catalogue.GetBus(lhs).name < catalogue.GetBus(rhs).name;
+            });
+
+            // Автобусы каждой остановки, в алфавитном порядке
+            std::vector<std::vector<BusId>> buses_by_stop(stop_count);
+            for (const BusId bus_id : buses_by_name) {
+                for (const StopId stop_id : catalogue.GetBus(bus_id).stops) {
+                    auto& stop_buses = buses_by_stop[stop_id];
+                    if (stop_buses.empty() || stop_buses.back() != bus_id) {
+                        stop_buses.push_back(bus_id);
+                    }
+                }
+            }
+
+            std::vector<StopRecord> stops;
+            std::vector<BusId> stop_buses;
+            std::vector<DistanceRecord> distances;
+            stops.reserve(stop_count);
+            for (StopId id = 0; id < stop_count; ++id) {
+                const Stop& stop = catalogue.GetStop(id);
+                StopRecord record{};
+                record.name = add_string(stop.name);
+                record.lat = stop.coordinates.lat;
+                record.lng = stop.coordinates.lng;
+
+                auto& own_buses = buses_by_stop[id];
+                own_buses.erase(std::unique(own_buses.begin(), own_buses.end()), own_buses.end());
+                record.buses_begin = static_cast<uint32_t>(stop_buses.size());
+                stop_buses.insert(stop_buses.end(), own_buses.begin(), own_buses.end());
+                record.buses_end = static_cast<uint32_t>(stop_buses.size());
+
+                auto& own_distances = distances_by_stop[id];
+                std::sort(own_distances.begin(), own_distances.end(), [](const DistanceRecord& lhs, const DistanceRecord& rhs) {
+                    return lhs.to < rhs.to;
+                });
+                record.distances_begin = static_cast<uint32_t>(distances.size());
+                distances.insert(distances.end(), own_distances.begin(), own_distances.end());
+                record.distances_end = static_cast<uint32_t>(distances.size());
+
+                stops.push_back(record);
+            }
+
+            std::vector<StopId> stops_by_name(stop_count);
+            for (StopId id = 0; id < stop_count; ++id) {
+                stops_by_name[id] = id;
+            }
+            std::sort(stops_by_name.begin(), stops_by_name.end(), [&catalogue](StopId lhs, StopId rhs) {
+                return catalogue.GetStop(lhs).name < catalogue.GetStop(rhs).name;
+            });
+
+            std::vector<BusRecord> buses;
+            std::vector<StopId> bus_stops;
+            buses.reserve(bus_count);
+            for (BusId id = 0; id < bus_count; ++id) {
+                const BusRoute& bus = catalogue.GetBus(id);
+                const BusInfo info = catalogue.GetBusInfo(bus.name).value();
+                BusRecord record{};
+                record.name = add_string(bus.name);
+                record.stops_begin = static_cast<uint32_t>(bus_stops.size());
+                bus_stops.insert(bus_stops.end(), bus.stops.begin(), bus.stops.end());
+                record.stops_end = static_cast<uint32_t>(bus_stops.size());
+                record.route_length = info.route_length;
+                record.curvature = info.curvature;
+                record.stop_count = info.stop_count;
+                record.unique_stop_count = info.unique_stop_count;
+                record.is_circular = bus.is_circular;
+                buses.push_back(record);
+            }
+
+            Header header{};
+            std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+            header.version = FORMAT_VERSION;
+            header.stop_count = stop_count;
+            header.bus_count = bus_count;
+
+            // Разделы идут за заголовком, каждый выровнен на SECTION_ALIGNMENT
+            uint64_t offset = sizeof(Header);
+            auto place = [&offset](Section& section, size_t size) {
+                offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+                section = { offset, size };
+                offset += size;
+            };
+            place(header.strings, strings.size());
+            place(header.stops, stops.size() * sizeof(StopRecord));
+            place(header.stops_by_name, stops_by_name.size() * sizeof(StopId));
+            place(header.stop_buses, stop_buses.size() * sizeof(BusId));
+            place(header.distances, distances.size() * sizeof(DistanceRecord));
+            place(header.buses, buses.size() * sizeof(BusRecord));
+            place(header.buses_by_name, buses_by_name.size() * sizeof(BusId));
+            place(header.bus_stops, bus_stops.size() * sizeof(StopId));
+
+            uint64_t written = 0;
+            auto write = [&output, &written](const Section& section, const void* data) {
+                static constexpr char PADDING[SECTION_ALIGNMENT] = {};
+                output.write(PADDING, static_cast<std::streamsize>(section.offset - written));
+                output.write(static_cast<const char*>(data), static_cast<std::streamsize>(section.size));
+                written = section.offset + section.size;
+            };
+            write({ 0, sizeof(Header) }, &header);
+            write(header.strings, strings.data());
+            write(header.stops, stops.data());
+            write(header.stops_by_name, stops_by_name.data());
+            write(header.stop_buses, stop_buses.data());
+            write(header.distances, distances.data());
+            write(header.buses, buses.data());
+            write(header.buses_by_name, buses_by_name.data());
+            write(header.bus_stops, bus_stops.data());
+        }
+
+#if defined(_WIN32)
+        MappedCatalogue::MappedCatalogue(const std::string& path) {
+            std::ifstream input(path, std::ios::binary);
+            if (!input) {
+                throw serialization::FormatError("Can't open " + path);
+            }
+            buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+            Validate();
+        }
+
+        MappedCatalogue::~MappedCatalogue() = default;
+#else
+        MappedCatalogue::MappedCatalogue(const std::string& path) {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw serialization::FormatError("Can't open " + path);
+            }
+            struct stat file_stat {};
+            if (::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+                ::close(fd);
+                throw serialization::FormatError("Can't map " + path);
+            }
+            size_ = static_cast<size_t>(file_stat.st_size);
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                throw serialization::FormatError("Can't map " + path);
+            }
+            data_ = static_cast<const char*>(data);
+
+            try {
+                Validate();
+            }
+            catch (...) {
+                ::munmap(const_cast<char*>(data_), size_);
+                throw;
+            }
+        }
+
+        MappedCatalogue::~MappedCatalogue() {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+
+        /*
+         * Проверяет заголовок, границы разделов и каждую запись: смещения строк, диапазоны в общих
+         * массивах и номера остановок и автобусов. После этого чтение обходится без проверок,
+         * а повреждённый файл даёт FormatError, а не обращение за пределы отображения
+         */
+        void MappedCatalogue::Validate() {
+            if (size_ < sizeof(Header)) {
+                throw serialization::FormatError("Mapped catalogue is truncated");
+            }
+            header_ = reinterpret_cast<const Header*>(data_);
+            if (!std::equal(std::begin(MAGIC), std::end(MAGIC), header_->magic)) {
+                throw serialization::FormatError("Not a mapped transport catalogue");
+            }
+            if (header_->version != FORMAT_VERSION) {
+                throw serialization::FormatError("Unsupported mapped catalogue version " + std::to_string(header_->version));
+            }
+
+            auto check = [this](const Section& section, uint64_t expected_size, size_t element_size) {
+                if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size_ || section.size > size_ - section.offset
+                    || (expected_size != 0 && section.size != expected_size) || section.size % element_size != 0) {
+                    throw serialization::FormatError("Mapped catalogue section is out of bounds");
+                }
+                return section.size / element_size;
+            };
+            const uint32_t stop_count = header_->stop_count;
+            const uint32_t bus_count = header_->bus_count;
+            const uint64_t strings_size = check(header_->strings, 0, 1);
+            check(header_->stops, uint64_t{ stop_count } * sizeof(StopRecord), sizeof(StopRecord));
+            check(header_->stops_by_name, uint64_t{ stop_count } * sizeof(StopId), sizeof(StopId));
+            const uint64_t stop_buses_count = check(header_->stop_buses, 0, sizeof(BusId));
+            const uint64_t distances_count = check(header_->distances, 0, sizeof(DistanceRecord));
+            check(header_->buses, uint64_t{ bus_count } * sizeof(BusRecord), sizeof(BusRecord));
+            check(header_->buses_by_name, uint64_t{ bus_count } * sizeof(BusId), sizeof(BusId));
+            const uint64_t bus_stops_count = check(header_->bus_stops, 0, sizeof(StopId));
+
+            auto fail = [](const char* what) {
+                throw serialization::FormatError(std::string("Mapped catalogue has a damaged ") + what);
+            };
+            auto check_string = [strings_size, &fail](StringRef ref) {
+                if (ref.offset > strings_size || ref.length > strings_size - ref.offset) {
+                    fail("string reference");
+                }
+            };
+            auto check_range = [&fail](uint32_t begin, uint32_t end, uint64_t count, const char* what) {
+                if (begin > end || end > count) {
+                    fail(what);
+                }
+            };
+            auto check_ids = [&fail](const uint32_t* ids, uint64_t count, uint32_t limit, const char* what) {
+                for (uint64_t i = 0; i < count; ++i) {
+                    if (ids[i] >= limit) {
+                        fail(what);
+                    }
+                }
+            };
+
+            const StopRecord* stops = SectionData<StopRecord>(header_->stops);
+            for (uint32_t id = 0; id < stop_count; ++id) {
+                check_string(stops[id].name);
+                check_range(stops[id].buses_begin, stops[id].buses_end, stop_buses_count, "stop bus range");
+                check_range(stops[id].distances_begin, stops[id].distances_end, distances_count, "stop distance range");
+            }
+            const BusRecord* buses = SectionData<BusRecord>(header_->buses);
+            for (uint32_t id = 0; id < bus_count; ++id) {
+                check_string(buses[id].name);
+                check_range(buses[id].stops_begin, buses[id].stops_end, bus_stops_count, "bus stop range");
+            }
+            const DistanceRecord* distances = SectionData<DistanceRecord>(header_->distances);
+            for (uint64_t i = 0; i < distances_count; ++i) {
+                if (distances[i].to >= stop_count) {
+                    fail("distance record");
+                }
+            }
+            check_ids(SectionData<StopId>(header_->stops_by_name), stop_count, stop_count, "stop name index");
+            check_ids(SectionData<BusId>(header_->buses_by_name), bus_count, bus_count, "bus name index");
+            check_ids(SectionData<BusId>(header_->stop_buses), stop_buses_count, bus_count, "stop bus list");
+            check_ids(SectionData<StopId>(header_->bus_stops), bus_stops_count, stop_count, "bus stop list");
+        }
+
+        std::string_view MappedCatalogue::GetString(StringRef ref) const {
+            return { SectionData<char>(header_->strings) + ref.offset, ref.length };
+        }
+
+        std::optional<StopId> MappedCatalogue::FindStopId(std::string_view name) const {
+            const StopId* begin = SectionData<StopId>(header_->stops_by_name);
+            const StopId* end = begin + header_->stop_count;
+            const StopRecord* stops = SectionData<StopRecord>(header_->stops);
+            const StopId* it = std::lower_bound(begin, end, name, [this, stops](StopId id, std::string_view value) {
+                return GetString(stops[id].name) < value;
+            });
+            if (it == end || GetString(stops[*it].name) != name) {
+                return std::nullopt;
+            }
+            return *it;
+        }
+
+        std::optional<BusId> MappedCatalogue::FindBusId(std::string_view name) const {
+            const BusId* begin = SectionData<BusId>(header_->buses_by_name);
+            const BusId* end = begin + header_->bus_count;
+            const BusRecord* buses = SectionData<BusRecord>(header_->buses);
+            const BusId* it = std::lower_bound(begin, end, name, [this, buses](BusId id, std::string_view value) {
+                return GetString(buses[id].name) < value;
+            });
+            if (it == end || GetString(buses[*it].name) != name) {
+                return std::nullopt;
+            }
+            return *it;
+        }
+
+        std::optional<MappedCatalogue::StopView> MappedCatalogue::FindStop(std::string_view name) const {
+            const auto id = FindStopId(name);
+            if (!id) {
+                return std::nullopt;
+            }
+            const StopRecord& record = SectionData<StopRecord>(header_->stops)[*id];
+            return StopView{ GetString(record.name), { record.lat, record.lng }, *id };
+        }
+
+        std::optional<MappedCatalogue::BusView> MappedCatalogue::FindBus(std::string_view name) const {
+            const auto id = FindBusId(name);
+            if (!id) {
+                return std::nullopt;
+            }
+            const BusRecord& record = SectionData<BusRecord>(header_->buses)[*id];
+            const StopId* stops = SectionData<StopId>(header_->bus_stops);
+            return BusView{ GetString(record.name), { stops + record.stops_begin, stops + record.stops_end }, record.is_circular != 0, *id };
+        }
+
+        std::optional<BusInfo> MappedCatalogue::GetBusInfo(std::string_view name) const {
+            const auto id = FindBusId(name);
+            if (!id) {
+                return std::nullopt;
+            }
+            const BusRecord& record = SectionData<BusRecord>(header_->buses)[*id];
+            return BusInfo{ record.stop_count, record.unique_stop_count, record.route_length, record.curvature };
+        }
+
+        std::optional<std::vector<std::string_view>> MappedCatalogue::GetBusesForStop(std::string_view stop_name) const {
+            const auto id = FindStopId(stop_name);
+            if (!id) {
+                return std::nullopt;
+            }
+            const StopRecord& record = SectionData<StopRecord>(header_->stops)[*id];
+            const BusId* bus_ids = SectionData<BusId>(header_->stop_buses);
+            const BusRecord* buses = SectionData<BusRecord>(header_->buses);
+
+            std::vector<std::string_view> names;
+            names.reserve(record.buses_end - record.buses_begin);
+            for (uint32_t i = record.buses_begin; i < record.buses_end; ++i) {
+                names.push_back(GetString(buses[bus_ids[i]].name));
+            }
+            return names;
+        }
+
+        std::optional<double> MappedCatalogue::GetDistance(StopId from, StopId to) const {
+            if (from >= header_->stop_count) {
+                return std::nullopt;
+            }
+            const StopRecord& record = SectionData<StopRecord>(header_->stops)[from];
+            const DistanceRecord* begin = SectionData<DistanceRecord>(header_->distances) + record.distances_begin;
+            const DistanceRecord* end = SectionData<DistanceRecord>(header_->distances) + record.distances_end;
+            const DistanceRecord* it = std::lower_bound(begin, end, to, [](const DistanceRecord& distance, StopId value) {
+                return distance.to < value;
+            });
+            if (it == end || it->to != to) {
+                return std::nullopt;
+            }
+            return it->distance;
+        }
+
+        size_t MappedCatalogue::GetStopCount() const {
+            return header_->stop_count;
+        }
+
+        size_t MappedCatalogue::GetBusCount() const {
+            return header_->bus_count;
+        }
+
+    } // namespace catalogue
+} // namespace transport
@@ -0,0 +1,135 @@
+// mapped_catalogue.h
+
+#pragma once
+
+#include "geo.h"
+#include "ranges.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+    namespace catalogue {
+
+        /*
+         * Справочник только для чтения, данные которого лежат прямо в отображённом в память файле.
+         * Все ссылки внутри файла - смещения, поэтому после открытия ничего не десериализуется,
+         * а несколько процессов на одной машине используют одну копию страниц из кеша ОС.
+         * Статистика маршрутов вычисляется при записи файла
+         */
+        class MappedCatalogue {
+        public:
+            static constexpr uint32_t FORMAT_VERSION = 1;
+
+            // Записывает справочник в формате, пригодном для отображения в память
+            static void Write(std::ostream& output, const TransportCatalogue& catalogue);
+
+            // Бросает serialization::FormatError, если файл повреждён или другой версии
+            explicit MappedCatalogue(const std::string& path);
+            MappedCatalogue(const MappedCatalogue&) = delete;
+            MappedCatalogue& operator=(const MappedCatalogue&) = delete;
+            ~MappedCatalogue();
+
+            struct StopView {
+                std::string_view name;
+                geo::Coordinates coordinates;
+                StopId id;
+            };
+
+            struct BusView {
+                std::string_view name;
+                ranges::Range<const StopId*> stops;
+                bool is_circular;
+                BusId id;
+            };
+
+            std::optional<StopView> FindStop(std::string_view name) const;
+            std::optional<BusView> FindBus(std::string_view name) const;
+            std::optional<BusInfo> GetBusInfo(std::string_view name) const;
+            // Названия автобусов по алфавиту; nullopt, если остановки нет
+            std::optional<std::vector<std::string_view>> GetBusesForStop(std::string_view stop_name) const;
+            std::optional<double> GetDistance(StopId from, StopId to) const;
+
+            size_t GetStopCount() const;
+            size_t GetBusCount() const;
+
+        private:
+            struct StringRef {
+                uint32_t offset;
+                uint32_t length;
+            };
+
+            struct StopRecord {
+                StringRef name;
+                double lat;
+                double lng;
+                uint32_t buses_begin;
+                uint32_t buses_end;
+                uint32_t distances_begin;
+                uint32_t distances_end;
+            };
+
+            struct BusRecord {
+                StringRef name;
+                uint32_t stops_begin;
+                uint32_t stops_end;
+                double route_length;
+                double curvature;
+                int32_t stop_count;
+                int32_t unique_stop_count;
+                uint32_t is_circular;
+                uint32_t reserved;
+            };
+
+            struct DistanceRecord {
+                StopId to;
+                int32_t distance;
+            };
+
+            // Смещение и размер раздела в байтах от начала файла
+            struct Section {
+                uint64_t offset;
+                uint64_t size;
+            };
+
+            struct Header {
+                char magic[8];
+                uint32_t version;
+                uint32_t stop_count;
+                uint32_t bus_count;
+                uint32_t reserved;
+                Section strings;
+                Section stops;          // StopRecord по StopId
+                Section stops_by_name;  // StopId, упорядоченные по названию
+                Section stop_buses;     // BusId каждой остановки, по названию автобуса
+                Section distances;      // DistanceRecord каждой остановки, по StopId назначения
+                Section buses;          // BusRecord по BusId
+                Section buses_by_name;  // BusId, упорядоченные по названию
+                Section bus_stops;      // StopId маршрутов
+            };
+
+            template <typename T>
+            const T* SectionData(const Section& section) const {
+                return reinterpret_cast<const T*>(data_ + section.offset);
+            }
+
+            std::string_view GetString(StringRef ref) const;
+            std::optional<StopId> FindStopId(std::string_view name) const;
+            std::optional<BusId> FindBusId(std::string_view name) const;
+            void Validate();
+
+            const char* data_ = nullptr;
+            size_t size_ = 0;
+            const Header* header_ = nullptr;
+#if defined(_WIN32)
+            std::vector<char> buffer_; // без mmap файл читается в память целиком
+#endif
+        };
+
+    } // namespace catalogue
+} // namespace transport
@@ -0,0 +1,63 @@
+// number_format.cpp
+
+#include "number_format.h"
+
+#include <charconv>
+#include <ostream>
+
+namespace number_format {
+
+    namespace {
+
+        // Знак, цифры мантиссы, точка и порядок вида e-308
+        size_t MaxDoubleSize(int precision) {
+            return static_cast<size_t>(precision) + 8;
+        }
+
+        // Как в printf: отрицательная точность означает точность по умолчанию
+        int NormalizePrecision(std::streamsize precision) {
+            return precision < 0 ? DEFAULT_PRECISION : static_cast<int>(precision);
+        }
+
+        char* FormatDouble(char* first, char* last, double value, int precision) {
+            return std::to_chars(first, last, value, std::chars_format::general, precision).ptr;
+        }
+
+    }  // namespace
+
+    void AppendDouble(std::string& output, double value, int precision) {
+        precision = NormalizePrecision(precision);
+        const size_t size = output.size();
+        output.resize(size + MaxDoubleSize(precision));
+        char* const begin = output.data() + size;
+        char* const end = FormatDouble(begin, output.data() + output.size(), value, precision);
+        output.resize(size + static_cast<size_t>(end - begin));
+    }
+
+    void AppendInt(std::string& output, long long value) {
+        char chars[24];
+        const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+        output.append(chars, result.ptr);
+    }
+
+    void WriteDouble(std::ostream& output, double value) {
+        const int precision = NormalizePrecision(output.precision());
+        char chars[64];
+        if (MaxDoubleSize(precision) <= sizeof(chars)) {
+            const char* end = FormatDouble(chars, chars + sizeof(chars), value, precision);
+            output.write(chars, end - chars);
+        }
+        else {
+            std::string text;
+            AppendDouble(text, value, precision);
+            output.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+    }
+
+    void WriteInt(std::ostream& output, long long value) {
+        char chars[24];
+        const auto result = std::to_chars(chars, chars + sizeof(chars), value);
+        output.write(chars, result.ptr - chars);
+    }
+
+}  // namespace number_format
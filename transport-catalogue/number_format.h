@@ -0,0 +1,25 @@
+// number_format.h
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+/*
+ * Запись чисел в текст через std::to_chars, без локали и виртуальных вызовов потока.
+ * Вещественные числа записываются так же, как printf("%.*g"), то есть как operator<<
+ * потока с флагами по умолчанию и заданной точностью; целые - как operator<<
+ */
+namespace number_format {
+
+    // Точность потока по умолчанию
+    inline constexpr int DEFAULT_PRECISION = 6;
+
+    void AppendDouble(std::string& output, double value, int precision = DEFAULT_PRECISION);
+    void AppendInt(std::string& output, long long value);
+
+    // Точность берётся из потока, как это делает operator<<
+    void WriteDouble(std::ostream& output, double value);
+    void WriteInt(std::ostream& output, long long value);
+
+}  // namespace number_format
@@ -0,0 +1,364 @@
+// profiler.cpp
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace profiler {
+
+    namespace {
+
+        constexpr uint32_t MAX_SCOPES = 64;
+
+        // Пишет только поток-владелец, поэтому хватает отдельных load и store;
+        // атомарность нужна, чтобы сводку можно было читать из другого потока
+        struct ScopeCounters {
+            std::atomic<uint64_t> count = 0;
+            std::atomic<uint64_t> total_ns = 0;
+            std::atomic<uint64_t> min_ns = std::numeric_limits<uint64_t>::max();
+            std::atomic<uint64_t> max_ns = 0;
+        };
+
+        using ThreadCounters = std::array<ScopeCounters, MAX_SCOPES>;
+
+        struct ScopeTotals {
+            uint64_t count = 0;
+            uint64_t total_ns = 0;
+            uint64_t min_ns = std::numeric_limits<uint64_t>::max();
+            uint64_t max_ns = 0;
+
+            void Add(const ScopeCounters& counters) {
+                count += counters.count.load(std::memory_order_relaxed);
+                total_ns += counters.total_ns.load(std::memory_order_relaxed);
+                min_ns = std::min(min_ns, counters.min_ns.load(std::memory_order_relaxed));
+                max_ns = std::max(max_ns, counters.max_ns.load(std::memory_order_relaxed));
+            }
+
+            void Add(const ScopeTotals& other) {
+                count += other.count;
+                total_ns += other.total_ns;
+                min_ns = std::min(min_ns, other.min_ns);
+                max_ns = std::max(max_ns, other.max_ns);
+            }
+        };
+
+        struct TraceEvent {
+            uint32_t scope;
+            uint64_t start_ns;
+            uint64_t duration_ns;
+        };
+
+        // Кольцевой буфер событий одного потока. Пока он не заполнен, события добавляются в конец,
+        // потом next указывает на самое старое, которое будет затёрто следующим
+        struct TraceBuffer {
+            uint32_t thread_id = 0;
+            bool is_main = false;
+            std::vector<TraceEvent> events;
+            size_t next = 0;
+            uint64_t dropped = 0;
+
+            void Add(const TraceEvent& event, size_t capacity) {
+                if (events.size() < capacity) {
+                    events.push_back(event);
+                    return;
+                }
+                events[next] = event;
+                next = next + 1 == events.size() ? 0 : next + 1;
+                ++dropped;
+            }
+
+            template <typename Callback>
+            void ForEach(Callback callback) const {
+                for (size_t i = next; i < events.size(); ++i) {
+                    callback(events[i]);
+                }
+                for (size_t i = 0; i < next; ++i) {
+                    callback(events[i]);
+                }
+            }
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::string> names; // индекс - номер области
+            std::vector<const ThreadCounters*> threads;
+            std::array<ScopeTotals, MAX_SCOPES> finished_threads;
+
+            // Трассировка: буферы работающих потоков и перенесённые из завершившихся
+            std::vector<const TraceBuffer*> traces;
+            std::vector<TraceBuffer> finished_traces;
+            uint32_t next_thread_id = 1;
+            std::atomic<size_t> trace_capacity = 0;
+            uint64_t trace_start_ns = 0;
+            std::thread::id main_thread;
+            std::unique_ptr<std::ofstream> trace_file;
+            std::string trace_path;
+        };
+
+        // Не разрушается: к нему обращаются деструкторы thread_local и обработчик atexit
+        Registry& GetRegistry() {
+            static Registry* registry = new Registry;
+            return *registry;
+        }
+
+        // Счётчики и события потока; при завершении потока они переносятся в finished_threads и finished_traces
+        class ThreadSlot {
+        public:
+            ThreadSlot() {
+                Registry& registry = GetRegistry();
+                std::lock_guard lock(registry.mutex);
+                registry.threads.push_back(&counters_);
+                registry.traces.push_back(&trace_);
+                trace_.thread_id = registry.next_thread_id++;
+                trace_.is_main = std::this_thread::get_id() == registry.main_thread;
+            }
+
+            ~ThreadSlot() {
+                Registry& registry = GetRegistry();
+                std::lock_guard lock(registry.mutex);
+                for (uint32_t scope = 0; scope < MAX_SCOPES; ++scope) {
+                    ScopeTotals totals;
+                    totals.Add(counters_[scope]);
+                    registry.finished_threads[scope].Add(totals);
+                }
+                registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &counters_));
+                registry.traces.erase(std::find(registry.traces.begin(), registry.traces.end(), &trace_));
+                if (!trace_.events.empty()) {
+                    registry.finished_traces.push_back(std::move(trace_));
+                }
+            }
+
+            ThreadCounters& Get() {
+                return counters_;
+            }
+
+            TraceBuffer& GetTrace() {
+                return trace_;
+            }
+
+        private:
+            ThreadCounters counters_;
+            TraceBuffer trace_;
+        };
+
+        void Update(std::atomic<uint64_t>& value, uint64_t new_value) {
+            value.store(new_value, std::memory_order_relaxed);
+        }
+
+        void PrintSummaryToCerr() {
+            if (IsEnabled()) {
+                PrintSummary(std::cerr);
+            }
+        }
+
+        void WriteTraceFile() {
+            if (!IsTracing()) {
+                return;
+            }
+            Registry& registry = GetRegistry();
+            WriteTrace(*registry.trace_file);
+            registry.trace_file->flush();
+            if (!*registry.trace_file) {
+                std::cerr << "Error: can't write trace " << registry.trace_path << std::endl;
+            }
+        }
+
+        // Имена областей задаются в коде, но кавычки и управляющие символы всё равно экранируются
+        void WriteJsonString(std::ostream& out, std::string_view value) {
+            out << '"';
+            for (const char c : value) {
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out << escaped;
+                }
+                else {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+        // Формат требует микросекунды; наносекунды идут дробной частью
+        void WriteMicroseconds(std::ostream& out, uint64_t ns) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+                static_cast<unsigned long long>(ns / 1000), static_cast<unsigned long long>(ns % 1000));
+            out << buffer;
+        }
+
+    }  // namespace
+
+    namespace detail {
+
+        uint32_t RegisterScope(std::string_view name) {
+            Registry& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            const auto it = std::find(registry.names.begin(), registry.names.end(), name);
+            if (it != registry.names.end()) {
+                return static_cast<uint32_t>(it - registry.names.begin());
+            }
+            if (registry.names.size() == MAX_SCOPES) {
+                return MAX_SCOPES; // лишние области не считаются
+            }
+            registry.names.emplace_back(name);
+            return static_cast<uint32_t>(registry.names.size() - 1);
+        }
+
+        void Record(uint32_t scope, uint64_t start_ns, uint64_t end_ns) {
+            if (scope >= MAX_SCOPES) {
+                return;
+            }
+            thread_local ThreadSlot slot;
+            const uint32_t current_mode = mode.load(std::memory_order_relaxed);
+            const uint64_t duration_ns = end_ns - start_ns;
+            if (current_mode & SUMMARY) {
+                ScopeCounters& counters = slot.Get()[scope];
+                Update(counters.count, counters.count.load(std::memory_order_relaxed) + 1);
+                Update(counters.total_ns, counters.total_ns.load(std::memory_order_relaxed) + duration_ns);
+                if (duration_ns < counters.min_ns.load(std::memory_order_relaxed)) {
+                    Update(counters.min_ns, duration_ns);
+                }
+                if (duration_ns > counters.max_ns.load(std::memory_order_relaxed)) {
+                    Update(counters.max_ns, duration_ns);
+                }
+            }
+            if (current_mode & TRACE) {
+                slot.GetTrace().Add({ scope, start_ns, duration_ns },
+                    GetRegistry().trace_capacity.load(std::memory_order_relaxed));
+            }
+        }
+
+    }  // namespace detail
+
+    void SetEnabled(bool enabled) {
+        if (!enabled) {
+            detail::mode.fetch_and(~detail::SUMMARY, std::memory_order_relaxed);
+            return;
+        }
+        detail::mode.fetch_or(detail::SUMMARY, std::memory_order_relaxed);
+        static std::once_flag at_exit;
+        std::call_once(at_exit, [] {
+            std::atexit(PrintSummaryToCerr);
+        });
+    }
+
+    void PrintSummary(std::ostream& out) {
+        Registry& registry = GetRegistry();
+        std::vector<std::pair<std::string, ScopeTotals>> rows;
+        {
+            std::lock_guard lock(registry.mutex);
+            for (uint32_t scope = 0; scope < registry.names.size(); ++scope) {
+                ScopeTotals totals = registry.finished_threads[scope];
+                for (const ThreadCounters* counters : registry.threads) {
+                    totals.Add((*counters)[scope]);
+                }
+                if (totals.count != 0) {
+                    rows.emplace_back(registry.names[scope], totals);
+                }
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second.total_ns > rhs.second.total_ns;
+        });
+
+        const auto flags = out.flags();
+        out << std::left << std::setw(32) << "scope" << std::right
+            << std::setw(10) << "count" << std::setw(16) << "total, ns" << std::setw(14) << "avg, ns"
+            << std::setw(14) << "min, ns" << std::setw(14) << "max, ns" << '\n';
+        for (const auto& [name, totals] : rows) {
+            out << std::left << std::setw(32) << name << std::right
+                << std::setw(10) << totals.count << std::setw(16) << totals.total_ns
+                << std::setw(14) << totals.total_ns / totals.count
+                << std::setw(14) << totals.min_ns << std::setw(14) << totals.max_ns << '\n';
+        }
+        out.flush();
+        out.flags(flags);
+    }
+
+    void EnableTracing(const std::string& path, size_t events_per_thread) {
+        Registry& registry = GetRegistry();
+        {
+            std::lock_guard lock(registry.mutex);
+            auto file = std::make_unique<std::ofstream>(path);
+            if (!*file) {
+                throw std::runtime_error("Can't open trace " + path);
+            }
+            registry.trace_file = std::move(file);
+            registry.trace_path = path;
+            registry.trace_capacity.store(std::max<size_t>(events_per_thread, 1), std::memory_order_relaxed);
+            registry.trace_start_ns = detail::NowNs();
+            registry.main_thread = std::this_thread::get_id();
+        }
+        detail::mode.fetch_or(detail::TRACE, std::memory_order_relaxed);
+        static std::once_flag at_exit;
+        std::call_once(at_exit, [] {
+            std::atexit(WriteTraceFile);
+        });
+    }
+
+    /*
+     * Каждый замер пишется одним событием "X" с началом и длительностью, а не парой "B"/"E":
+     * при затирании старых событий в буфере не остаётся начал без концов.
+     * Время отсчитывается от включения трассировки, номера потоков - в порядке их первого замера
+     */
+    void WriteTrace(std::ostream& out) {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        std::vector<const TraceBuffer*> buffers(registry.traces.begin(), registry.traces.end());
+        for (const TraceBuffer& buffer : registry.finished_traces) {
+            buffers.push_back(&buffer);
+        }
+        std::sort(buffers.begin(), buffers.end(), [](const TraceBuffer* lhs, const TraceBuffer* rhs) {
+            return lhs->thread_id < rhs->thread_id;
+        });
+
+        uint64_t dropped = 0;
+        bool first = true;
+        const auto start_event = [&out, &first] {
+            out << (first ? "\n" : ",\n");
+            first = false;
+        };
+
+        out << "{\"traceEvents\":[";
+        for (const TraceBuffer* buffer : buffers) {
+            dropped += buffer->dropped;
+            start_event();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"args\":{\"name\":";
+            WriteJsonString(out, buffer->is_main ? "main" : "thread " + std::to_string(buffer->thread_id));
+            out << "}}";
+
+            buffer->ForEach([&](const TraceEvent& event) {
+                const uint64_t start = event.start_ns > registry.trace_start_ns ? event.start_ns - registry.trace_start_ns : 0;
+                start_event();
+                out << "{\"name\":";
+                WriteJsonString(out, registry.names[event.scope]);
+                out << ",\"ph\":\"X\",\"ts\":";
+                WriteMicroseconds(out, start);
+                out << ",\"dur\":";
+                WriteMicroseconds(out, event.duration_ns);
+                out << ",\"pid\":1,\"tid\":" << buffer->thread_id << '}';
+            });
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+    }
+
+}  // namespace profiler
@@ -0,0 +1,105 @@
+// profiler.h
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+/*
+ * Замер времени областей кода. PROFILE_SCOPE("имя") измеряет время до конца текущей области;
+ * по каждому имени копятся число вызовов, суммарное, минимальное и максимальное время в нс.
+ * Каждый поток пишет только в свои счётчики, без блокировок и вывода, а сводка по всем
+ * потокам выводится один раз - при завершении программы.
+ *
+ * Кроме сводки можно включить трассировку (EnableTracing): каждый замер сохраняется как событие
+ * с началом, длительностью и номером потока в кольцевой буфер своего потока, а при завершении
+ * программы все события записываются в файл формата Chrome Trace Event, который открывается
+ * в chrome://tracing и ui.perfetto.dev. Когда буфер заполнен, новые события затирают самые старые.
+ *
+ * Выключается при сборке макросом PROFILER_DISABLED и во время работы - SetEnabled(false);
+ * выключенный замер стоит одного чтения атомарного флага
+ */
+
+namespace profiler {
+
+    namespace detail {
+
+        // Биты режима: сводка и трассировка включаются независимо
+        constexpr uint32_t SUMMARY = 1;
+        constexpr uint32_t TRACE = 2;
+
+        inline std::atomic<uint32_t> mode = 0;
+
+        // Номер области по имени; области с одинаковыми именами считаются вместе
+        uint32_t RegisterScope(std::string_view name);
+        void Record(uint32_t scope, uint64_t start_ns, uint64_t end_ns);
+
+        inline uint64_t NowNs() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+    }  // namespace detail
+
+    // При первом включении регистрирует вывод сводки в std::cerr при выходе из программы;
+    // если к выходу замер выключен, сводка не выводится
+    void SetEnabled(bool enabled);
+
+    inline bool IsEnabled() {
+        return (detail::mode.load(std::memory_order_relaxed) & detail::SUMMARY) != 0;
+    }
+
+    // Сводка по всем потокам, от областей с наибольшим суммарным временем
+    void PrintSummary(std::ostream& out);
+
+    // Включает трассировку с этого момента; при выходе из программы события пишутся в файл path.
+    // Файл открывается сразу, чтобы ошибка в пути обнаружилась до начала работы - тогда
+    // бросается std::runtime_error. В буфере каждого потока хранятся последние events_per_thread событий
+    void EnableTracing(const std::string& path, size_t events_per_thread = size_t{ 1 } << 20);
+
+    inline bool IsTracing() {
+        return (detail::mode.load(std::memory_order_relaxed) & detail::TRACE) != 0;
+    }
+
+    // События всех потоков в формате Chrome Trace Event. Буферы работающих потоков читаются
+    // без синхронизации с ними, поэтому вызывать, когда другие потоки уже не пишут замеры
+    void WriteTrace(std::ostream& out);
+
+    class ScopeTimer {
+    public:
+        explicit ScopeTimer(uint32_t scope)
+            : scope_(scope)
+            , start_ns_(detail::mode.load(std::memory_order_relaxed) != 0 ? detail::NowNs() : 0) {
+        }
+
+        ScopeTimer(const ScopeTimer&) = delete;
+        ScopeTimer& operator=(const ScopeTimer&) = delete;
+
+        ~ScopeTimer() {
+            if (start_ns_ != 0) {
+                detail::Record(scope_, start_ns_, detail::NowNs());
+            }
+        }
+
+    private:
+        uint32_t scope_;
+        uint64_t start_ns_;
+    };
+
+}  // namespace profiler
+
+#define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
+#define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
+
+#if defined(PROFILER_DISABLED)
+#define PROFILE_SCOPE(name) ((void)0)
+#else
+// Имя регистрируется один раз на место в коде
+#define PROFILE_SCOPE(name)                                                                              \
+    static const uint32_t PROFILE_CONCAT(profile_scope_, __LINE__) = ::profiler::detail::RegisterScope(name); \
+    ::profiler::ScopeTimer PROFILE_CONCAT(profile_timer_, __LINE__)(PROFILE_CONCAT(profile_scope_, __LINE__))
+#endif
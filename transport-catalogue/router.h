@@ -1,12 +1,15 @@
 // router.h
 #pragma once
 
+#include "contraction_hierarchy.h"
 #include "graph.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -15,13 +18,25 @@
 
 namespace graph {
 
+    enum class RouterMode {
+        DIJKSTRA,
+        CONTRACTION_HIERARCHIES,
+    };
+
+    /*
+     * Ищет кратчайшие пути по запросу.
+     * В режиме DIJKSTRA предварительных вычислений нет: конструктор только проверяет веса рёбер,
+     * а память под поиск (O(V)) выделяется один раз на поток и переиспользуется.
+     * В режиме CONTRACTION_HIERARCHIES конструктор один раз строит иерархию сжатий,
+     * после чего запросы просматривают лишь малую часть графа
+     */
     template <typename Weight>
     class Router {
     private:
         using Graph = DirectedWeightedGraph<Weight>;
 
     public:
-        explicit Router(const Graph& graph);
+        explicit Router(const Graph& graph, RouterMode mode = RouterMode::DIJKSTRA);
 
         struct RouteInfo {
             Weight weight;
@@ -30,89 +45,173 @@ namespace graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        // Сохраняет результат предобработки; graph при загрузке должен совпадать с исходным
+        void Save(std::ostream& output) const;
+        static Router Load(const Graph& graph, std::istream& input);
+
     private:
-        struct RouteInternalData {
+        Router(const Graph& graph, std::optional<ContractionHierarchy<Weight>> hierarchy);
+
+        std::optional<RouteInfo> BuildRouteDijkstra(VertexId from, VertexId to) const;
+
+        struct QueueItem {
             Weight weight;
-            std::optional<EdgeId> prev_edge;
-        };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
-
-        void InitializeRoutesInternalData(const Graph& graph) {
-            const size_t vertex_count = graph.GetVertexCount();
-            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
-                for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                    const auto& edge = graph.GetEdge(edge_id);
-                    if (edge.weight < ZERO_WEIGHT) {
-                        throw std::domain_error("Edges' weights should be non-negative");
-                    }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
-                    }
-                }
-            }
-        }
+            VertexId vertex;
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-            const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+            bool operator>(const QueueItem& other) const {
+                return weight > other.weight;
             }
-        }
+        };
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                        }
-                    }
+        // Состояние поиска. После запроса сбрасываются только затронутые вершины
+        struct SearchState {
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+            std::vector<VertexId> touched;
+            std::vector<QueueItem> queue;
+
+            void Prepare(size_t vertex_count) {
+                for (const VertexId vertex : touched) {
+                    weights[vertex] = UNREACHED_WEIGHT;
+                    prev_edges[vertex] = NO_EDGE;
+                }
+                touched.clear();
+                queue.clear();
+                if (weights.size() < vertex_count) {
+                    weights.resize(vertex_count, UNREACHED_WEIGHT);
+                    prev_edges.resize(vertex_count, NO_EDGE);
                 }
             }
+        };
+
+        static SearchState& GetSearchState() {
+            static thread_local SearchState state;
+            return state;
         }
 
         static constexpr Weight ZERO_WEIGHT{};
+        static constexpr Weight UNREACHED_WEIGHT = std::numeric_limits<Weight>::max();
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
         const Graph& graph_;
-        RoutesInternalData routes_internal_data_;
+        std::optional<ContractionHierarchy<Weight>> hierarchy_;
     };
 
     template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    Router<Weight>::Router(const Graph& graph, RouterMode mode)
         : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
     {
-        InitializeRoutesInternalData(graph);
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Router requires a frozen graph");
+        }
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdgeWeight(edge_id) < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+        if (mode == RouterMode::CONTRACTION_HIERARCHIES) {
+            hierarchy_.emplace(graph);
+        }
+    }
 
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, std::optional<ContractionHierarchy<Weight>> hierarchy)
+        : graph_(graph)
+        , hierarchy_(std::move(hierarchy))
+    {
+    }
+
+    template <typename Weight>
+    void Router<Weight>::Save(std::ostream& output) const {
+        serialization::WritePod<uint8_t>(output, hierarchy_.has_value());
+        if (hierarchy_) {
+            hierarchy_->Save(output);
         }
     }
 
+    template <typename Weight>
+    Router<Weight> Router<Weight>::Load(const Graph& graph, std::istream& input) {
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Router requires a frozen graph");
+        }
+        std::optional<ContractionHierarchy<Weight>> hierarchy;
+        if (serialization::ReadPod<uint8_t>(input) != 0) {
+            hierarchy.emplace(ContractionHierarchy<Weight>::Load(graph, input));
+        }
+        return Router(graph, std::move(hierarchy));
+    }
+
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
         VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        if (hierarchy_) {
+            auto path = hierarchy_->FindPath(from, to);
+            if (!path) {
+                return std::nullopt;
+            }
+            return RouteInfo{ path->weight, std::move(path->edges) };
+        }
+        return BuildRouteDijkstra(from, to);
+    }
+
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRouteDijkstra(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        SearchState& state = GetSearchState();
+        state.Prepare(vertex_count);
+        auto& weights = state.weights;
+        auto& prev_edges = state.prev_edges;
+        auto& queue = state.queue;
+
+        weights[from] = ZERO_WEIGHT;
+        state.touched.push_back(from);
+        queue.push_back({ ZERO_WEIGHT, from });
+
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const QueueItem item = queue.back();
+            queue.pop_back();
+
+            if (item.weight > weights[item.vertex]) {
+                continue;
+            }
+            if (item.vertex == to) {
+                break;
+            }
+
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+                const VertexId edge_to = graph_.GetEdgeTarget(edge_id);
+                const Weight candidate_weight = item.weight + graph_.GetEdgeWeight(edge_id);
+                Weight& weight_to = weights[edge_to];
+                if (candidate_weight < weight_to) {
+                    if (weight_to == UNREACHED_WEIGHT) {
+                        state.touched.push_back(edge_to);
+                    }
+                    weight_to = candidate_weight;
+                    prev_edges[edge_to] = edge_id;
+                    queue.push_back({ candidate_weight, edge_to });
+                    std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                }
+            }
+        }
+
+        if (weights[to] == UNREACHED_WEIGHT) {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
+
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-        {
-            edges.push_back(*edge_id);
+        for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdgeSource(edges.back())) {
+            edges.push_back(prev_edges[vertex]);
         }
         std::reverse(edges.begin(), edges.end());
 
-        return RouteInfo{ weight, std::move(edges) };
+        return RouteInfo{ weights[to], std::move(edges) };
     }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -0,0 +1,94 @@
+// serialization.h
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Запись и чтение простых значений и массивов в двоичном виде (порядок байт и размеры типов
+ * машины, на которой сохраняли). Используется снимком справочника и маршрутизатора
+ */
+namespace serialization {
+
+    class FormatError : public std::runtime_error {
+    public:
+        using runtime_error::runtime_error;
+    };
+
+    template <typename T>
+    void WritePod(std::ostream& output, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T ReadPod(std::istream& input) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        if (!input.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw FormatError("Unexpected end of snapshot");
+        }
+        return value;
+    }
+
+    template <typename T>
+    void WriteVector(std::ostream& output, const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WritePod<uint64_t>(output, values.size());
+        output.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    namespace detail {
+
+        // Больше этого объёма заранее не выделяется: повреждённый размер не должен приводить
+        // к огромному выделению памяти, а настоящие данные просто дочитываются частями
+        constexpr uint64_t MAX_CHUNK_BYTES = uint64_t{ 1 } << 20;
+
+        // Читает size элементов в container, увеличивая его не больше чем вдвое за шаг
+        template <typename Container>
+        void ReadElements(std::istream& input, Container& container, uint64_t size) {
+            using T = typename Container::value_type;
+            if (size > std::numeric_limits<uint64_t>::max() / sizeof(T)) {
+                throw FormatError("Invalid array size in snapshot");
+            }
+            uint64_t read = 0;
+            while (read < size) {
+                const uint64_t chunk = std::min(size - read, std::max<uint64_t>(read, MAX_CHUNK_BYTES / sizeof(T) + 1));
+                container.resize(static_cast<size_t>(read + chunk));
+                if (!input.read(reinterpret_cast<char*>(container.data() + read), static_cast<std::streamsize>(chunk * sizeof(T)))) {
+                    throw FormatError("Unexpected end of snapshot");
+                }
+                read += chunk;
+            }
+        }
+
+    } // namespace detail
+
+    template <typename T>
+    std::vector<T> ReadVector(std::istream& input) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::vector<T> values;
+        detail::ReadElements(input, values, ReadPod<uint64_t>(input));
+        return values;
+    }
+
+    inline void WriteString(std::ostream& output, const std::string& value) {
+        WritePod<uint64_t>(output, value.size());
+        output.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    inline std::string ReadString(std::istream& input) {
+        std::string value;
+        detail::ReadElements(input, value, ReadPod<uint64_t>(input));
+        return value;
+    }
+
+} // namespace serialization
@@ -0,0 +1,107 @@
+// snapshot.cpp
+
+#include "snapshot.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace transport {
+    namespace snapshot {
+
+        using namespace catalogue;
+        using namespace serialization;
+
+        namespace {
+            constexpr char MAGIC[8] = { 'T', 'C', 'S', 'N', 'A', 'P', 'S', 'H' };
+
+            struct DistanceRecord {
+                StopId from;
+                StopId to;
+                int distance;
+            };
+        }
+
+        void WriteHeader(std::ostream& output) {
+            output.write(MAGIC, sizeof(MAGIC));
+            WritePod(output, FORMAT_VERSION);
+        }
+
+        void ReadHeader(std::istream& input) {
+            char magic[sizeof(MAGIC)];
+            if (!input.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), std::begin(MAGIC))) {
+                throw FormatError("Not a transport catalogue snapshot");
+            }
+            if (const auto version = ReadPod<uint32_t>(input); version != FORMAT_VERSION) {
+                throw FormatError("Unsupported snapshot version " + std::to_string(version));
+            }
+        }
+
+        void SaveCatalogue(std::ostream& output, const TransportCatalogue& catalogue) {
+            WritePod<uint64_t>(output, catalogue.GetStopCount());
+            for (StopId id = 0; id < catalogue.GetStopCount(); ++id) {
+                const Stop& stop = catalogue.GetStop(id);
+                WriteString(output, stop.name);
+                WritePod(output, stop.coordinates);
+            }
+
+            std::vector<DistanceRecord> distances;
+            catalogue.ForEachDistance([&distances](const Stop& from, const Stop& to, int distance) {
+                distances.push_back({ from.id, to.id, distance });
+            });
+            WriteVector(output, distances);
+
+            WritePod<uint64_t>(output, catalogue.GetBusCount());
+            for (BusId id = 0; id < catalogue.GetBusCount(); ++id) {
+                const BusRoute& bus = catalogue.GetBus(id);
+                WriteString(output, bus.name);
+                WritePod<uint8_t>(output, bus.is_circular);
+                WriteVector(output, bus.stops);
+            }
+        }
+
+        void LoadCatalogue(std::istream& input, TransportCatalogue& catalogue) {
+            if (catalogue.GetStopCount() != 0 || catalogue.GetBusCount() != 0) {
+                throw std::logic_error("Snapshot can be loaded only into an empty catalogue");
+            }
+
+            // Сначала все остановки без расстояний, чтобы номера совпали с сохранёнными
+            const auto stop_count = ReadPod<uint64_t>(input);
+            std::unordered_map<std::string, int> no_distances;
+            for (uint64_t i = 0; i < stop_count; ++i) {
+                const std::string name = ReadString(input);
+                const auto coordinates = ReadPod<geo::Coordinates>(input);
+                catalogue.AddStop(name, coordinates, no_distances);
+            }
+
+            auto check_stop = [stop_count](StopId id) {
+                if (id >= stop_count) {
+                    throw FormatError("Stop id is out of range in snapshot");
+                }
+                return id;
+            };
+
+            for (const DistanceRecord& distance : ReadVector<DistanceRecord>(input)) {
+                catalogue.AddDistance(catalogue.GetStop(check_stop(distance.from)).name,
+                    catalogue.GetStop(check_stop(distance.to)).name, distance.distance);
+            }
+
+            const auto bus_count = ReadPod<uint64_t>(input);
+            std::vector<std::string_view> stop_names;
+            for (uint64_t i = 0; i < bus_count; ++i) {
+                const std::string name = ReadString(input);
+                const bool is_circular = ReadPod<uint8_t>(input) != 0;
+                stop_names.clear();
+                for (const StopId stop_id : ReadVector<StopId>(input)) {
+                    stop_names.push_back(catalogue.GetStop(check_stop(stop_id)).name);
+                }
+                catalogue.AddBus(name, stop_names, is_circular);
+            }
+        }
+
+    } // namespace snapshot
+} // namespace transport
@@ -0,0 +1,28 @@
+// snapshot.h
+
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <iosfwd>
+
+/*
+ * Двоичный снимок справочника (и, по желанию, построенного маршрутизатора).
+ * Файл начинается с сигнатуры и номера версии формата; снимок другой версии не читается
+ */
+namespace transport {
+    namespace snapshot {
+
+        constexpr uint32_t FORMAT_VERSION = 1;
+
+        void WriteHeader(std::ostream& output);
+        // Бросает serialization::FormatError, если сигнатура или версия не совпадают
+        void ReadHeader(std::istream& input);
+
+        void SaveCatalogue(std::ostream& output, const catalogue::TransportCatalogue& catalogue);
+        // Остановки и маршруты получают те же номера, что были при сохранении
+        void LoadCatalogue(std::istream& input, catalogue::TransportCatalogue& catalogue);
+
+    } // namespace snapshot
+} // namespace transport
@@ -15,16 +15,25 @@ namespace svg {
         }
 
         void RenderColor(std::ostream& out, Rgb rgb) {
-            out << "rgb("sv << static_cast<int>(rgb.red)  //
-                << ',' << static_cast<int>(rgb.green)     //
-                << ',' << static_cast<int>(rgb.blue) << ')';
+            out << "rgb("sv;
+            number_format::WriteInt(out, rgb.red);
+            out.put(',');
+            number_format::WriteInt(out, rgb.green);
+            out.put(',');
+            number_format::WriteInt(out, rgb.blue);
+            out.put(')');
         }
 
         void RenderColor(std::ostream& out, Rgba rgba) {
-            out << "rgba("sv << static_cast<int>(rgba.red)  //
-                << ',' << static_cast<int>(rgba.green)      //
-                << ',' << static_cast<int>(rgba.blue)       //
-                << ',' << rgba.opacity << ')';
+            out << "rgba("sv;
+            number_format::WriteInt(out, rgba.red);
+            out.put(',');
+            number_format::WriteInt(out, rgba.green);
+            out.put(',');
+            number_format::WriteInt(out, rgba.blue);
+            out.put(',');
+            number_format::WriteDouble(out, rgba.opacity);
+            out.put(')');
         }
 
     }  // namespace
@@ -82,7 +91,7 @@ namespace svg {
         // Делегируем вывод тэга своим подклассам
         RenderObject(context);
 
-        context.out << std::endl;
+        context.out.put('\n');
     }
 
     // Circle
@@ -99,8 +108,13 @@ namespace svg {
 
     void Circle::RenderObject(const RenderContext& context) const {
         auto& out = context.out;
-        out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-        out << "r=\""sv << radius_ << "\" "sv;
+        out << "<circle cx=\""sv;
+        number_format::WriteDouble(out, center_.x);
+        out << "\" cy=\""sv;
+        number_format::WriteDouble(out, center_.y);
+        out << "\" r=\""sv;
+        number_format::WriteDouble(out, radius_);
+        out << "\" "sv;
         RenderAttrs(out);
         out << "/>"sv;
     }
@@ -123,7 +137,9 @@ namespace svg {
             else {
                 out << ' ';
             }
-            out << p.x << ',' << p.y;
+            number_format::WriteDouble(out, p.x);
+            out.put(',');
+            number_format::WriteDouble(out, p.y);
         }
         out << "\" "sv;
         RenderAttrs(out);
@@ -190,8 +206,8 @@ namespace svg {
     }
 
     void Document::Render(std::ostream& out) const {
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
         RenderContext ctx{ out, 2, 2 };
         for (const auto& obj : objects_) {
             obj->Render(ctx);
@@ -201,6 +217,14 @@ namespace svg {
 
     namespace detail {
 
+        void RenderPathStyle(std::ostream& out, const PathStyle& style) {
+            RenderOptionalAttr(out, "fill"sv, style.fill_color);
+            RenderOptionalAttr(out, " stroke"sv, style.stroke_color);
+            RenderOptionalAttr(out, " stroke-width"sv, style.stroke_width);
+            RenderOptionalAttr(out, " stroke-linecap"sv, style.stroke_line_cap);
+            RenderOptionalAttr(out, " stroke-linejoin"sv, style.stroke_line_join);
+        }
+
         void HtmlEncodeString(std::ostream& out, std::string_view sv) {
             for (char c : sv) {
                 switch (c) {
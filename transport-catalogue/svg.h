@@ -1,5 +1,7 @@
 #pragma once
 
+#include "number_format.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -25,6 +27,17 @@ namespace svg {
             HtmlEncodeString(out, s);
         }
 
+        // Числа пишутся через std::to_chars, минуя форматирование потока
+        template <>
+        inline void RenderValue<double>(std::ostream& out, const double& value) {
+            number_format::WriteDouble(out, value);
+        }
+
+        template <>
+        inline void RenderValue<uint32_t>(std::ostream& out, const uint32_t& value) {
+            number_format::WriteInt(out, value);
+        }
+
         template <typename AttrType>
         inline void RenderAttr(std::ostream& out, std::string_view name, const AttrType& value) {
             using namespace std::literals;
@@ -63,6 +76,8 @@ namespace svg {
         uint8_t red = 0;
         uint8_t green = 0;
         uint8_t blue = 0;
+
+        bool operator==(const Rgb&) const = default;
     };
 
     struct Rgba {
@@ -78,6 +93,8 @@ namespace svg {
         uint8_t green = 0;
         uint8_t blue = 0;
         double opacity = 1.0;
+
+        bool operator==(const Rgba&) const = default;
     };
 
     using Color = std::variant<std::monostate, std::string, Rgb, Rgba>;
@@ -148,27 +165,45 @@ namespace svg {
 
     std::ostream& operator<<(std::ostream& out, StrokeLineJoin value);
 
+    // Свойства заливки и обводки элемента
+    struct PathStyle {
+        std::optional<Color> fill_color;
+        std::optional<Color> stroke_color;
+        std::optional<double> stroke_width;
+        std::optional<StrokeLineCap> stroke_line_cap;
+        std::optional<StrokeLineJoin> stroke_line_join;
+
+        bool operator==(const PathStyle&) const = default;
+    };
+
+    namespace detail {
+
+        // Атрибуты fill, stroke, stroke-width, stroke-linecap и stroke-linejoin в этом порядке
+        void RenderPathStyle(std::ostream& out, const PathStyle& style);
+
+    }  // namespace detail
+
     template <typename Owner>
     class PathProps {
     public:
         Owner& SetFillColor(Color color) {
-            fill_color_ = std::move(color);
+            style_.fill_color = std::move(color);
             return AsOwner();
         }
         Owner& SetStrokeColor(Color color) {
-            stroke_color_ = std::move(color);
+            style_.stroke_color = std::move(color);
             return AsOwner();
         }
         Owner& SetStrokeWidth(double width) {
-            stroke_width_ = width;
+            style_.stroke_width = width;
             return AsOwner();
         }
         Owner& SetStrokeLineCap(StrokeLineCap line_cap) {
-            stroke_line_cap_ = line_cap;
+            style_.stroke_line_cap = line_cap;
             return AsOwner();
         }
         Owner& SetStrokeLineJoin(StrokeLineJoin line_join) {
-            stroke_line_join_ = line_join;
+            style_.stroke_line_join = line_join;
             return AsOwner();
         }
 
@@ -176,13 +211,7 @@ namespace svg {
         ~PathProps() = default;
 
         void RenderAttrs(std::ostream& out) const {
-            using detail::RenderOptionalAttr;
-            using namespace std::literals;
-            RenderOptionalAttr(out, "fill"sv, fill_color_);
-            RenderOptionalAttr(out, " stroke"sv, stroke_color_);
-            RenderOptionalAttr(out, " stroke-width"sv, stroke_width_);
-            RenderOptionalAttr(out, " stroke-linecap"sv, stroke_line_cap_);
-            RenderOptionalAttr(out, " stroke-linejoin"sv, stroke_line_join_);
+            detail::RenderPathStyle(out, style_);
         }
 
     private:
@@ -192,11 +221,7 @@ namespace svg {
             return static_cast<Owner&>(*this);
         }
 
-        std::optional<Color> fill_color_;
-        std::optional<Color> stroke_color_;
-        std::optional<double> stroke_width_;
-        std::optional<StrokeLineCap> stroke_line_cap_;
-        std::optional<StrokeLineJoin> stroke_line_join_;
+        PathStyle style_;
     };
 
     /*
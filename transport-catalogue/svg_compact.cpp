@@ -0,0 +1,296 @@
+// svg_compact.cpp
+
+#include "svg_compact.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace svg {
+
+    using namespace std::literals;
+
+    namespace {
+
+        // Размер порции, которой текст документа передаётся в поток
+        constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+        // Ломаная в потоковом режиме выводится частями такого размера
+        constexpr size_t POLYLINE_FLUSH_THRESHOLD = 4 * 1024;
+        constexpr std::string_view INDENT = "  "sv;
+        constexpr std::string_view HEADER = "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+        constexpr std::string_view FOOTER = "</svg>"sv;
+
+        void AppendHtmlEncoded(std::string& out, std::string_view text) {
+            for (const char c : text) {
+                switch (c) {
+                case '"':
+                    out += "&quot;"sv;
+                    break;
+                case '<':
+                    out += "&lt;"sv;
+                    break;
+                case '>':
+                    out += "&gt;"sv;
+                    break;
+                case '&':
+                    out += "&amp;"sv;
+                    break;
+                case '\'':
+                    out += "&apos;"sv;
+                    break;
+                default:
+                    out += c;
+                }
+            }
+        }
+
+        void AppendAttr(std::string& out, std::string_view name, double value, int precision) {
+            out += name;
+            out += "=\""sv;
+            number_format::AppendDouble(out, value, precision);
+            out += '"';
+        }
+
+        template <typename T>
+        uint32_t FindOrAdd(std::vector<T>& items, const T& item) {
+            const auto it = std::find(items.begin(), items.end(), item);
+            if (it != items.end()) {
+                return static_cast<uint32_t>(it - items.begin());
+            }
+            items.push_back(item);
+            return static_cast<uint32_t>(items.size() - 1);
+        }
+
+        std::string RenderStyle(const PathStyle& style, std::streamsize precision) {
+            std::ostringstream out;
+            out.precision(precision);
+            detail::RenderPathStyle(out, style);
+            return out.str();
+        }
+
+        std::string RenderFont(const FontStyle& font) {
+            std::ostringstream out;
+            detail::RenderAttr(out, " font-size"sv, font.size);
+            if (!font.family.empty()) {
+                detail::RenderAttr(out, " font-family"sv, font.family);
+            }
+            if (!font.weight.empty()) {
+                detail::RenderAttr(out, " font-weight"sv, font.weight);
+            }
+            return out.str();
+        }
+
+        // Элементы выводятся с отступом и переводом строки, как в Document
+
+        void AppendCircle(std::string& out, std::string_view style, Point center, double radius, int precision) {
+            out += INDENT;
+            out += "<circle"sv;
+            AppendAttr(out, " cx"sv, center.x, precision);
+            AppendAttr(out, " cy"sv, center.y, precision);
+            AppendAttr(out, " r"sv, radius, precision);
+            out += ' ';
+            out += style;
+            out += "/>\n"sv;
+        }
+
+        void AppendPolylineStart(std::string& out) {
+            out += INDENT;
+            out += "<polyline points=\""sv;
+        }
+
+        void AppendPolylinePoint(std::string& out, Point point, bool first, int precision) {
+            if (!first) {
+                out += ' ';
+            }
+            number_format::AppendDouble(out, point.x, precision);
+            out += ',';
+            number_format::AppendDouble(out, point.y, precision);
+        }
+
+        void AppendPolylineEnd(std::string& out, std::string_view style) {
+            out += "\" "sv;
+            out += style;
+            out += "/>\n"sv;
+        }
+
+        void AppendText(std::string& out, std::string_view style, std::string_view font,
+            Point position, Point offset, std::string_view data, int precision) {
+            out += INDENT;
+            out += "<text "sv;
+            out += style;
+            AppendAttr(out, " x"sv, position.x, precision);
+            AppendAttr(out, " y"sv, position.y, precision);
+            AppendAttr(out, " dx"sv, offset.x, precision);
+            AppendAttr(out, " dy"sv, offset.y, precision);
+            out += font;
+            out += '>';
+            out += data;
+            out += "</text>\n"sv;
+        }
+
+    }  // namespace
+
+    CompactDocument::CompactDocument(std::ostream& out)
+        : stream_(&out)
+        , precision_(static_cast<int>(out.precision())) {
+        buffer_ += HEADER;
+        WriteBuffer();
+    }
+
+    CompactDocument::StyleId CompactDocument::AddStyle(const PathStyle& style) {
+        const StyleId id = FindOrAdd(styles_, style);
+        if (stream_ && id == style_texts_.size()) {
+            style_texts_.push_back(RenderStyle(style, precision_));
+        }
+        return id;
+    }
+
+    CompactDocument::FontId CompactDocument::AddFont(const FontStyle& font) {
+        const FontId id = FindOrAdd(fonts_, font);
+        if (stream_ && id == font_texts_.size()) {
+            font_texts_.push_back(RenderFont(font));
+        }
+        return id;
+    }
+
+    CompactDocument::StringRef CompactDocument::AddString(std::string_view text) {
+        if (stream_) {
+            texts_.clear();
+        }
+        const size_t offset = texts_.size();
+        AppendHtmlEncoded(texts_, text);
+        return { static_cast<uint32_t>(offset), static_cast<uint32_t>(texts_.size() - offset) };
+    }
+
+    void CompactDocument::AddCircle(StyleId style, Point center, double radius) {
+        if (stream_) {
+            CloseElement();
+            AppendCircle(buffer_, style_texts_.at(style), center, radius, precision_);
+            WriteBuffer();
+            return;
+        }
+        elements_.emplace_back(CircleElement{ style, center, radius });
+    }
+
+    void CompactDocument::StartPolyline(StyleId style) {
+        if (stream_) {
+            CloseElement();
+            AppendPolylineStart(buffer_);
+            open_polyline_ = PolylineElement{ style, 0, 0 };
+            return;
+        }
+        elements_.emplace_back(PolylineElement{ style, static_cast<uint32_t>(points_.size()), 0 });
+    }
+
+    void CompactDocument::AddPoint(Point point) {
+        if (stream_) {
+            if (!open_polyline_) {
+                throw std::logic_error("AddPoint without StartPolyline"s);
+            }
+            AppendPolylinePoint(buffer_, point, open_polyline_->point_count++ == 0, precision_);
+            if (buffer_.size() >= POLYLINE_FLUSH_THRESHOLD) {
+                WriteBuffer();
+            }
+            return;
+        }
+        points_.push_back(point);
+        ++std::get<PolylineElement>(elements_.back()).point_count;
+    }
+
+    void CompactDocument::AddText(StyleId style, FontId font, Point position, Point offset, StringRef data) {
+        if (stream_) {
+            CloseElement();
+            AppendText(buffer_, style_texts_.at(style), font_texts_.at(font), position, offset,
+                std::string_view(texts_).substr(data.offset, data.size), precision_);
+            WriteBuffer();
+            return;
+        }
+        elements_.emplace_back(TextElement{ style, font, position, offset, data });
+    }
+
+    void CompactDocument::Reserve(size_t element_count, size_t point_count, size_t text_size) {
+        if (stream_) {
+            return;
+        }
+        elements_.reserve(element_count);
+        points_.reserve(point_count);
+        texts_.reserve(text_size);
+    }
+
+    // Стили и шрифты выводятся в текст один раз, с точностью потока out
+    void CompactDocument::Render(std::ostream& out) const {
+        if (stream_) {
+            throw std::logic_error("Render is not available in streaming mode"s);
+        }
+        const int precision = static_cast<int>(out.precision());
+
+        std::vector<std::string> style_texts;
+        style_texts.reserve(styles_.size());
+        for (const PathStyle& style : styles_) {
+            style_texts.push_back(RenderStyle(style, out.precision()));
+        }
+        std::vector<std::string> font_texts;
+        font_texts.reserve(fonts_.size());
+        for (const FontStyle& font : fonts_) {
+            font_texts.push_back(RenderFont(font));
+        }
+
+        std::string buffer;
+        buffer.reserve(FLUSH_THRESHOLD + 4096);
+        buffer += HEADER;
+
+        for (const Element& element : elements_) {
+            std::visit([&](const auto& item) {
+                using T = std::decay_t<decltype(item)>;
+                if constexpr (std::is_same_v<T, CircleElement>) {
+                    AppendCircle(buffer, style_texts[item.style], item.center, item.radius, precision);
+                }
+                else if constexpr (std::is_same_v<T, PolylineElement>) {
+                    AppendPolylineStart(buffer);
+                    for (uint32_t i = 0; i < item.point_count; ++i) {
+                        AppendPolylinePoint(buffer, points_[item.first_point + i], i == 0, precision);
+                    }
+                    AppendPolylineEnd(buffer, style_texts[item.style]);
+                }
+                else {
+                    AppendText(buffer, style_texts[item.style], font_texts[item.font], item.position, item.offset,
+                        std::string_view(texts_).substr(item.data.offset, item.data.size), precision);
+                }
+            }, element);
+
+            if (buffer.size() >= FLUSH_THRESHOLD) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+
+        buffer += FOOTER;
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    void CompactDocument::Finish() {
+        if (!stream_) {
+            throw std::logic_error("Finish is available only in streaming mode"s);
+        }
+        CloseElement();
+        buffer_ += FOOTER;
+        WriteBuffer();
+    }
+
+    // Дописывает конец незакрытой ломаной
+    void CompactDocument::CloseElement() {
+        if (open_polyline_) {
+            AppendPolylineEnd(buffer_, style_texts_.at(open_polyline_->style));
+            open_polyline_.reset();
+            WriteBuffer();
+        }
+    }
+
+    void CompactDocument::WriteBuffer() {
+        stream_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+}  // namespace svg
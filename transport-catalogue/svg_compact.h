@@ -0,0 +1,114 @@
+// svg_compact.h
+
+#pragma once
+
+#include "svg.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace svg {
+
+    // Атрибуты шрифта элемента <text>; пустые family и weight не выводятся
+    struct FontStyle {
+        uint32_t size = 1;
+        std::string family;
+        std::string weight;
+
+        bool operator==(const FontStyle&) const = default;
+    };
+
+    /*
+     * Документ SVG без отдельного объекта в куче на каждый элемент. Элементы лежат подряд
+     * в одном векторе в виде variant и выводятся без виртуальных вызовов; вершины всех
+     * ломаных хранятся в общем массиве, а тексты - в общем буфере, уже экранированными.
+     * Стили и шрифты регистрируются один раз и хранятся без повторов, элементы ссылаются
+     * на них по номеру. Выводит тот же текст, что и Document с такими же Circle, Polyline и Text.
+     *
+     * В потоковом режиме элементы не хранятся: каждый выводится в поток сразу после добавления,
+     * и в памяти держится только текущий элемент. Вывод завершает Finish
+     */
+    class CompactDocument {
+    public:
+        using StyleId = uint32_t;
+        using FontId = uint32_t;
+
+        // Участок буфера текстов
+        struct StringRef {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        CompactDocument() = default;
+        // Потоковый режим; заголовок документа выводится сразу
+        explicit CompactDocument(std::ostream& out);
+
+        // Повторная регистрация такого же стиля или шрифта возвращает прежний номер.
+        // Поиск линейный: различных стилей в документе немного
+        StyleId AddStyle(const PathStyle& style);
+        FontId AddFont(const FontStyle& font);
+        // Текст можно использовать в нескольких элементах, например в подложке и надписи.
+        // В потоковом режиме ссылка действительна до следующего вызова AddString
+        StringRef AddString(std::string_view text);
+
+        void AddCircle(StyleId style, Point center, double radius);
+        // Начинает ломаную; вершины добавляются через AddPoint до начала следующего элемента
+        void StartPolyline(StyleId style);
+        void AddPoint(Point point);
+        void AddText(StyleId style, FontId font, Point position, Point offset, StringRef data);
+
+        // Резервирует память, чтобы заполнение документа обошлось без перевыделений
+        void Reserve(size_t element_count, size_t point_count, size_t text_size);
+
+        // Выводит документ, построенный в обычном режиме
+        void Render(std::ostream& out) const;
+        // Завершает документ в потоковом режиме
+        void Finish();
+
+    private:
+        struct CircleElement {
+            StyleId style;
+            Point center;
+            double radius;
+        };
+
+        struct PolylineElement {
+            StyleId style;
+            uint32_t first_point;
+            uint32_t point_count;
+        };
+
+        struct TextElement {
+            StyleId style;
+            FontId font;
+            Point position;
+            Point offset;
+            StringRef data;
+        };
+
+        using Element = std::variant<CircleElement, PolylineElement, TextElement>;
+
+        std::vector<Element> elements_;
+        std::vector<Point> points_;
+        std::string texts_;
+        std::vector<PathStyle> styles_;
+        std::vector<FontStyle> fonts_;
+
+        // потоковый режим
+        void CloseElement();
+        void WriteBuffer();
+
+        std::ostream* stream_ = nullptr;
+        int precision_ = 0;
+        std::vector<std::string> style_texts_;
+        std::vector<std::string> font_texts_;
+        std::string buffer_; // текущий элемент
+        std::optional<PolylineElement> open_polyline_;
+    };
+
+}  // namespace svg
@@ -0,0 +1,146 @@
+// number_format_test.cpp
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++20 -O2 -I. tests/number_format_test.cpp number_format.cpp -o number_format_test
+
+#include "number_format.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << std::endl;
+            ++failures;
+        }
+    }
+
+    // Вывод должен побайтно совпадать с operator<< потока с флагами по умолчанию
+    void CheckDouble(double value, int precision) {
+        std::ostringstream expected;
+        expected.precision(precision);
+        expected << value;
+
+        std::string appended;
+        number_format::AppendDouble(appended, value, precision);
+
+        std::ostringstream written;
+        written.precision(precision);
+        number_format::WriteDouble(written, value);
+
+        if (appended != expected.str() || written.str() != expected.str()) {
+            std::ostringstream message;
+            message << "bits " << std::hex << std::bit_cast<uint64_t>(value) << std::dec << " precision " << precision
+                << ": operator<< \"" << expected.str() << "\", AppendDouble \"" << appended
+                << "\", WriteDouble \"" << written.str() << "\"";
+            Check(false, message.str());
+        }
+    }
+
+    void CheckInt(long long value) {
+        std::ostringstream expected;
+        expected << value;
+
+        std::string appended;
+        number_format::AppendInt(appended, value);
+
+        std::ostringstream written;
+        number_format::WriteInt(written, value);
+
+        Check(appended == expected.str() && written.str() == expected.str(), "integer " + expected.str());
+    }
+
+    const std::vector<int> PRECISIONS = { 0, 1, 2, 3, 5, 6, 7, 10, 15, 16, 17, 20, 25 };
+
+    std::vector<double> EdgeValues() {
+        using limits = std::numeric_limits<double>;
+        std::vector<double> values = {
+            0.0, 1.0, 0.1, 0.5, 0.125, 0.15, 2.5, 9.5, 99.5, 1e-5, 1e-4, 0.0001234, 123456.0, 999999.5, 9.9999995,
+            1e15, 1e16, 1e17, 1e21, 1e100, 1e300, 9007199254740992.0, 9007199254740993.0, 3.0 / 7, 2.0 / 3,
+            55.611087, 37.20829, 1000.0 / 60, 6371000.0,
+            limits::infinity(), limits::quiet_NaN(),
+            limits::denorm_min(), limits::min(), limits::max(), limits::epsilon(),
+            2.2250738585072009e-308,  // наибольшее субнормальное
+        };
+        // Соседи каждого значения: на них проверяется округление последнего знака
+        const size_t count = values.size();
+        for (size_t i = 0; i < count; ++i) {
+            if (std::isfinite(values[i])) {
+                values.push_back(std::nextafter(values[i], 0.0));
+                values.push_back(std::nextafter(values[i], limits::infinity()));
+            }
+        }
+        // И все они с противоположным знаком, включая -0, -inf и -nan
+        for (size_t i = 0, size = values.size(); i < size; ++i) {
+            values.push_back(-values[i]);
+        }
+        return values;
+    }
+
+    void TestEdgeValues() {
+        for (const double value : EdgeValues()) {
+            for (const int precision : PRECISIONS) {
+                CheckDouble(value, precision);
+            }
+        }
+    }
+
+    // Случайные битовые образы покрывают все порядки, субнормальные числа и NaN с любой нагрузкой,
+    // а значения из диапазона координат и времён - то, что действительно попадает в вывод
+    void TestRandomValues() {
+        std::mt19937_64 random(2024);
+        std::uniform_real_distribution<double> moderate(-1e6, 1e6);
+        std::uniform_int_distribution<size_t> random_precision(0, PRECISIONS.size() - 1);
+        for (int i = 0; i < 100000; ++i) {
+            CheckDouble(std::bit_cast<double>(random()), PRECISIONS[random_precision(random)]);
+            CheckDouble(moderate(random), PRECISIONS[random_precision(random)]);
+        }
+    }
+
+    void TestIntegers() {
+        for (const long long value : { 0LL, 1LL, -1LL, 9LL, 10LL, -10LL, 2147483647LL, -2147483648LL,
+                 std::numeric_limits<long long>::max(), std::numeric_limits<long long>::min() }) {
+            CheckInt(value);
+        }
+        std::mt19937_64 random(7);
+        for (int i = 0; i < 10000; ++i) {
+            CheckInt(static_cast<long long>(random()) >> (i % 64));
+        }
+    }
+
+    // Запись в поток берёт точность из потока, в том числе точность по умолчанию
+    void TestStreamDefaultPrecision() {
+        std::ostringstream expected;
+        expected << 3.14159265358979 << ' ' << 1234567.0;
+        std::ostringstream written;
+        number_format::WriteDouble(written, 3.14159265358979);
+        written << ' ';
+        number_format::WriteDouble(written, 1234567.0);
+        Check(written.str() == expected.str(), "default precision: \"" + written.str() + "\" != \"" + expected.str() + "\"");
+    }
+
+}  // namespace
+
+int main() {
+    TestEdgeValues();
+    TestRandomValues();
+    TestIntegers();
+    TestStreamDefaultPrecision();
+
+    if (failures == 0) {
+        std::cout << "OK" << std::endl;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
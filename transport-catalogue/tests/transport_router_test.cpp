@@ -0,0 +1,89 @@
+// transport_router_test.cpp
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++20 -O2 -pthread -I. tests/transport_router_test.cpp $(ls *.cpp | grep -v main.cpp) -o router_test
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace transport::catalogue;
+
+namespace {
+
+    int failures = 0;
+
+    void Check(bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << std::endl;
+            ++failures;
+        }
+    }
+
+    /*
+     * Кольцевой B: S0 -> S1 -> S2 -> S0, некольцевой C: S1 - S3, все перегоны по 1000 м.
+     * Из S2 в S3 единственный путь: B до S0, снова B до S1 (кольцо не проходит S0 насквозь), затем C.
+     * Каждая поездка начинается с посадки, поэтому ожиданий три, а не два
+     */
+    void TestReboardingSameBus(const RoutingSettings& settings, const std::string& mode) {
+        TransportCatalogue catalogue;
+        std::unordered_map<std::string, int> s0{ {"S1", 1000} };
+        std::unordered_map<std::string, int> s1{ {"S2", 1000}, {"S3", 1000} };
+        std::unordered_map<std::string, int> s2{ {"S0", 1000} };
+        std::unordered_map<std::string, int> s3;
+        catalogue.AddStop("S0", { 55.60, 37.60 }, s0);
+        catalogue.AddStop("S1", { 55.61, 37.61 }, s1);
+        catalogue.AddStop("S2", { 55.62, 37.62 }, s2);
+        catalogue.AddStop("S3", { 55.63, 37.63 }, s3);
+        catalogue.AddBus("B", { "S0", "S1", "S2", "S0" }, true);
+        catalogue.AddBus("C", { "S1", "S3" }, false);
+
+        const TransportRouter router(settings, catalogue);
+        const auto route = router.GetRoute("S2", "S3");
+        Check(route.has_value(), mode + ": route S2 -> S3 exists");
+        if (!route) {
+            return;
+        }
+
+        const auto& [total_time, items] = *route;
+        // 3 ожидания по 2 минуты и 3 км при 60 км/ч
+        Check(std::abs(total_time - 9.0) < 1e-9, mode + ": total_time " + std::to_string(total_time) + " != 9");
+
+        double items_time = 0.0;
+        int waits = 0;
+        for (const auto& item : items) {
+            items_time += item.time;
+            waits += item.type == "Wait";
+        }
+        Check(waits == 3, mode + ": " + std::to_string(waits) + " Wait items instead of 3");
+        Check(std::abs(items_time - total_time) < 1e-9, mode + ": items sum to " + std::to_string(items_time));
+        Check(!items.empty() && items.front().type == "Wait" && items.front().name == "S2", mode + ": route starts with Wait at S2");
+    }
+
+}  // namespace
+
+int main() {
+    RoutingSettings settings;
+    settings.bus_velocity = 60;
+    settings.bus_wait_time = 2;
+
+    TestReboardingSameBus(settings, "dijkstra");
+
+    settings.router_mode = RouterMode::CONTRACTION_HIERARCHIES;
+    TestReboardingSameBus(settings, "contraction hierarchies");
+
+    settings.router_mode = RouterMode::DIJKSTRA;
+    settings.graph_model = GraphModel::RIDE_SEGMENTS;
+    TestReboardingSameBus(settings, "ride segments");
+
+    if (failures == 0) {
+        std::cout << "OK" << std::endl;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,65 +4,63 @@
 #include "geo.h"
 
 #include <algorithm>
+#include <stdexcept>
 #include <vector>
 
 namespace transport {
     namespace catalogue {
 
         void TransportCatalogue::AddStop(const std::string_view name, geo::Coordinates coordinates, std::unordered_map<std::string, int>& distances) {
-            auto it = stops_.find(name);
-            if (it != stops_.end()) {
-                it->second->coordinates = coordinates;
-            }
-            else {
-                stop_objects_.push_back({ std::string(name), coordinates });
-                Stop* stop_ptr = &stop_objects_.back();
-                stops_[stop_ptr->name] = stop_ptr;
-            }
+            Stop* stop = GetOrAddStop(name);
+            stop->coordinates = coordinates;
+            stop->unit_vector = geo::ToUnitVector(coordinates);
+            ++version_;
 
             for (const auto& [neighbor_name, distance] : distances) {
                 AddDistance(name, neighbor_name, distance);
             }
         }
 
-        void TransportCatalogue::AddDistance(const std::string_view stop_name, const std::string_view other_stop_name, int distance) {
-            Stop* stop = nullptr;
-
-            auto it = stops_.find(stop_name);
+        // Остановка могла встретиться раньше в расстояниях или маршруте - тогда она уже есть с нулевыми координатами
+        Stop* TransportCatalogue::GetOrAddStop(std::string_view name) {
+            auto it = stops_.find(name);
             if (it != stops_.end()) {
-                stop = it->second;
-            }
-            else {
-                stop_objects_.push_back({ std::string(stop_name), {0, 0} });
-                stop = &stop_objects_.back();
-                stops_[stop->name] = stop;
+                return it->second;
             }
+            const auto id = static_cast<StopId>(stop_objects_.size());
+            stop_objects_.push_back({ std::string(name), {0, 0}, geo::ToUnitVector({0, 0}), id });
+            stop_to_buses_.emplace_back();
+            Stop* stop = &stop_objects_.back();
+            stops_[stop->name] = stop;
+            return stop;
+        }
 
-            Stop* other_stop = nullptr;
+        void TransportCatalogue::AddDistance(const std::string_view stop_name, const std::string_view other_stop_name, int distance) {
+            Stop* stop = GetOrAddStop(stop_name);
+            Stop* other_stop = GetOrAddStop(other_stop_name);
 
-            auto other_it = stops_.find(other_stop_name);
-            if (other_it != stops_.end()) {
-                other_stop = other_it->second;
-            }
-            else {
-                stop_objects_.push_back({ std::string(other_stop_name), {0, 0} });
-                other_stop = &stop_objects_.back();
-                stops_[other_stop->name] = other_stop;
-            }
+            stop_distances_.Set(stop->id, other_stop->id, distance);
+            stop_distances_.Insert(other_stop->id, stop->id, distance);
+            ++version_;
+        }
 
-            stop_distances_[{stop, other_stop}] = distance;
-            if (stop_distances_.find({ other_stop, stop }) == stop_distances_.end()) {
-                stop_distances_[{other_stop, stop}] = distance;
+        void TransportCatalogue::AddBus(const std::string_view name, const std::vector<std::string_view>& stops, bool is_circular) {
+            std::vector<StopId> stop_ids;
+            stop_ids.reserve(stops.size());
+            for (const auto stop_name : stops) {
+                stop_ids.push_back(GetOrAddStop(stop_name)->id);
             }
-        }
 
-        void TransportCatalogue::AddBus(const std::string_view name, const std::vector<std::string>& stops, bool is_circular) {
-            bus_objects_.push_back({ std::string(name), stops, is_circular });
+            const auto id = static_cast<BusId>(bus_objects_.size());
+            bus_objects_.push_back({ std::string(name), std::move(stop_ids), is_circular, id });
             BusRoute* bus_ptr = &bus_objects_.back();
             buses_[bus_ptr->name] = bus_ptr;
+            bus_info_cache_.emplace_back();
+            route_distances_cache_.emplace_back();
+            ++version_;
 
-            for (const auto& stop : bus_ptr->stops) {
-                stop_to_buses_[stop].insert(bus_ptr->name);
+            for (const StopId stop_id : bus_ptr->stops) {
+                stop_to_buses_[stop_id].insert(bus_ptr->name);
             }
         }
 
@@ -88,33 +86,61 @@ namespace transport {
             }
         }
 
+        const Stop& TransportCatalogue::GetStop(StopId id) const {
+            return stop_objects_.at(id);
+        }
+
+        const BusRoute& TransportCatalogue::GetBus(BusId id) const {
+            return bus_objects_.at(id);
+        }
+
+        size_t TransportCatalogue::GetStopCount() const {
+            return stop_objects_.size();
+        }
+
+        size_t TransportCatalogue::GetBusCount() const {
+            return bus_objects_.size();
+        }
+
         std::optional<BusInfo> TransportCatalogue::GetBusInfo(std::string_view name) const {
             auto bus_it = buses_.find(name);
             if (bus_it == buses_.end()) {
                 return std::nullopt;
             }
 
-            const auto& bus = *bus_it->second;
+            CachedBusInfo& cached = bus_info_cache_[bus_it->second->id];
+            if (cached.version.load(std::memory_order_acquire) == version_) {
+                return cached.info;
+            }
+
+            const BusInfo info = ComputeBusInfo(*bus_it->second);
+            std::lock_guard lock(bus_info_mutex_);
+            // Значение могли записать, пока мы ждали блокировку, поэтому проверяем ещё раз
+            if (cached.version.load(std::memory_order_relaxed) != version_) {
+                cached.info = info;
+                cached.version.store(version_, std::memory_order_release);
+            }
+            return cached.info;
+        }
+
+        BusInfo TransportCatalogue::ComputeBusInfo(const BusRoute& bus) const {
             int stop_count = static_cast<int>(bus.stops.size());
-            std::unordered_set<std::string_view> unique_stops(bus.stops.begin(), bus.stops.end());
-            int unique_stop_count = static_cast<int>(unique_stops.size());
-            double route_length = 0.0;
-            double geo_length = 0.0;
+            std::vector<StopId> unique_stops(bus.stops.begin(), bus.stops.end());
+            std::sort(unique_stops.begin(), unique_stops.end());
+            int unique_stop_count = static_cast<int>(std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin());
 
-            for (size_t i = 1; i < bus.stops.size(); ++i) {
-                const Stop* from = stops_.at(bus.stops[i - 1]);
-                const Stop* to = stops_.at(bus.stops[i]);
-                route_length += stop_distances_.at({ from, to });
-                geo_length += geo::ComputeDistance(from->coordinates, to->coordinates);
+            const RouteDistances& distances = GetRouteDistances(bus.id);
+            if (!distances.AllKnown()) {
+                throw std::out_of_range("Distance between stops is not set");
             }
 
+            const size_t last = bus.stops.empty() ? 0 : bus.stops.size() - 1;
+            double route_length = distances.Forward(0, last);
+            double geo_length = distances.geo[last];
+
             if (!bus.is_circular) {
-                for (size_t i = bus.stops.size() - 1; i > 0; --i) {
-                    const Stop* from = stops_.at(bus.stops[i]);
-                    const Stop* to = stops_.at(bus.stops[i - 1]);
-                    route_length += stop_distances_.at({ from, to });
-                    geo_length += geo::ComputeDistance(from->coordinates, to->coordinates);
-                }
+                route_length += distances.Backward(last, 0);
+                geo_length *= 2;
                 stop_count = 2 * stop_count - 1; // Остановок туда-обратно без дублирования последней
             }
 
@@ -122,10 +148,70 @@ namespace transport {
             return BusInfo{ stop_count, unique_stop_count, route_length, curvature };
         }
 
+        const RouteDistances& TransportCatalogue::GetRouteDistances(BusId id) const {
+            CachedRouteDistances& cached = route_distances_cache_[id];
+            if (cached.version.load(std::memory_order_acquire) == version_) {
+                return cached.distances;
+            }
+
+            std::lock_guard lock(bus_info_mutex_);
+            if (cached.version.load(std::memory_order_relaxed) != version_) {
+                cached.distances = ComputeRouteDistances(bus_objects_[id]);
+                cached.version.store(version_, std::memory_order_release);
+            }
+            return cached.distances;
+        }
+
+        // Расстояния по дорогам суммируются как целые числа, поэтому разности префиксов точные
+        RouteDistances TransportCatalogue::ComputeRouteDistances(const BusRoute& bus) const {
+            const size_t stop_count = bus.stops.size();
+            RouteDistances result;
+            result.forward.assign(std::max<size_t>(stop_count, 1), 0.0);
+            if (!bus.is_circular) {
+                result.backward.assign(std::max<size_t>(stop_count, 1), 0.0);
+            }
+            const auto mark_unknown = [stop_count](std::vector<bool>& known, size_t position) {
+                if (known.empty()) {
+                    known.assign(stop_count, true);
+                }
+                known[position] = false;
+            };
+
+            for (size_t i = 1; i < stop_count; ++i) {
+                const auto forward = stop_distances_.Find(bus.stops[i - 1], bus.stops[i]);
+                result.forward[i] = result.forward[i - 1] + forward.value_or(0);
+                if (!forward) {
+                    mark_unknown(result.forward_known, i);
+                }
+                if (!bus.is_circular) {
+                    const auto backward = stop_distances_.Find(bus.stops[i], bus.stops[i - 1]);
+                    result.backward[i] = result.backward[i - 1] + backward.value_or(0);
+                    if (!backward) {
+                        mark_unknown(result.backward_known, i);
+                    }
+                }
+            }
+
+            // Длины отрезков пишутся на места со сдвигом на единицу и сразу складываются в префиксы
+            thread_local geo::UnitPath path;
+            path.Clear();
+            for (const StopId stop_id : bus.stops) {
+                path.Add(stop_objects_[stop_id].unit_vector);
+            }
+            result.geo.assign(std::max<size_t>(stop_count, 1), 0.0);
+            if (stop_count > 1) {
+                geo::ComputeSegmentLengths(path, result.geo.data() + 1);
+                for (size_t i = 2; i < stop_count; ++i) {
+                    result.geo[i] += result.geo[i - 1];
+                }
+            }
+            return result;
+        }
+
         const std::unordered_set<std::string_view>* TransportCatalogue::GetBusesForStop(std::string_view stop_name) const {
-            auto it = stop_to_buses_.find(stop_name);
-            if (it != stop_to_buses_.end()) {
-                return &it->second;
+            auto it = stops_.find(stop_name);
+            if (it != stops_.end()) {
+                return &stop_to_buses_[it->second->id];
             }
             else {
                 return nullptr;
@@ -140,16 +226,22 @@ namespace transport {
             return buses_;
         }
 
+        uint64_t TransportCatalogue::GetVersion() const {
+            return version_;
+        }
+
         std::optional <double> TransportCatalogue::GetDistance(std::string_view from, std::string_view to) const {
-            
-            auto stop_from = stops_.find(from);
-            auto stop_to = stops_.find(to);
-            
-            auto result_it = stop_distances_.find({ stop_from->second, stop_to->second });
-            if (result_it != stop_distances_.end()) {
-                return result_it->second;
-            }
-       
+            return GetDistance(stops_.at(from), stops_.at(to));
+        }
+
+        std::optional<double> TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
+            return GetDistance(from->id, to->id);
+        }
+
+        std::optional<double> TransportCatalogue::GetDistance(StopId from, StopId to) const {
+            if (const auto distance = stop_distances_.Find(from, to)) {
+                return *distance;
+            }
             return std::nullopt;
         }
 
@@ -2,7 +2,11 @@
 
 #pragma once
 
+#include "distance_table.h"
 #include "geo.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -14,15 +18,60 @@
 namespace transport {
     namespace catalogue {
 
+        // Плотные номера остановок и автобусов в порядке их добавления в справочник
+        using StopId = uint32_t;
+        using BusId = uint32_t;
+
         struct Stop {
             std::string name;
             geo::Coordinates coordinates;
+            // Точка на единичной сфере: считается при добавлении, чтобы длины маршрутов обходились без sin и cos
+            geo::UnitVector unit_vector;
+            StopId id = 0;
         };
 
         struct BusRoute {
             std::string name;
-            std::vector<std::string> stops;
+            std::vector<StopId> stops;
             bool is_circular;
+            BusId id = 0;
+        };
+
+        /*
+         * Накопленные вдоль маршрута расстояния; индекс - позиция остановки в BusRoute::stops.
+         * Путь между любыми двумя позициями - разность двух элементов.
+         * Перегон без заданного расстояния считается нулевым
+         */
+        struct RouteDistances {
+            // От первой остановки до i-й в прямом направлении
+            std::vector<double> forward;
+            // От i-й остановки до первой в обратном направлении; только для некольцевых маршрутов
+            std::vector<double> backward;
+            // По прямой от первой остановки до i-й; в обе стороны одинаково
+            std::vector<double> geo;
+            // Известно ли расстояние перегона между (i - 1)-й и i-й остановками.
+            // Заполняются, только если хотя бы одно расстояние неизвестно
+            std::vector<bool> forward_known;
+            std::vector<bool> backward_known;
+
+            bool AllKnown() const {
+                return forward_known.empty() && backward_known.empty();
+            }
+            bool ForwardKnown(size_t position) const {
+                return forward_known.empty() || forward_known[position];
+            }
+            bool BackwardKnown(size_t position) const {
+                return backward_known.empty() || backward_known[position];
+            }
+
+            // from <= to
+            double Forward(size_t from, size_t to) const {
+                return forward[to] - forward[from];
+            }
+            // from >= to
+            double Backward(size_t from, size_t to) const {
+                return backward[from] - backward[to];
+            }
         };
 
         struct BusInfo {
@@ -31,37 +80,75 @@ namespace transport {
             double route_length;
             double curvature;
         };
-        struct StopPairHasher {
-            std::size_t operator()(const std::pair<const Stop*, const Stop*>& StopsPair) const {
-                std::size_t left = std::hash<const void*>()(static_cast<const void*>(StopsPair.first));
-                std::size_t right = std::hash<const void*>()(static_cast<const void*>(StopsPair.second));
-                return left ^ (right << 1); // Комбинирование хешей
-            }
-        };
+
         class TransportCatalogue {
         public:
             void AddStop(const std::string_view name, geo::Coordinates coordinates, std::unordered_map<std::string, int>& distances);
-            void AddBus(const std::string_view name, const std::vector<std::string>& stops, bool is_circular);
+            void AddBus(const std::string_view name, const std::vector<std::string_view>& stops, bool is_circular);
             void AddDistance(const std::string_view stop_name, const std::string_view other_stop_name, int distance);
 
             const Stop* FindStop(std::string_view name) const;
             const BusRoute* FindBus(std::string_view name) const;
+            const Stop& GetStop(StopId id) const;
+            const BusRoute& GetBus(BusId id) const;
+            size_t GetStopCount() const;
+            size_t GetBusCount() const;
+            // Статистика считается при первом запросе и кешируется до следующего изменения справочника.
+            // Можно вызывать из нескольких потоков одновременно, если справочник в это время не меняется
             std::optional<BusInfo> GetBusInfo(std::string_view name) const;
             const std::unordered_set<std::string_view>* GetBusesForStop(std::string_view stop_name) const;
+            // Считается и кешируется так же, как статистика; ссылка действительна до изменения справочника
+            const RouteDistances& GetRouteDistances(BusId id) const;
 
             const std::unordered_map<std::string_view, Stop*>& GetAllStops() const;
             const std::unordered_map<std::string_view, BusRoute*>& GetAllBuses() const;
 
             std::optional <double>  GetDistance(std::string_view from, std::string_view to) const;
+            std::optional<double> GetDistance(const Stop* from, const Stop* to) const;
+            // Без поиска остановок по имени; предпочтительный вариант там, где известны номера
+            std::optional<double> GetDistance(StopId from, StopId to) const;
+
+            // Вызывает callback(from, to, distance) для каждого известного расстояния
+            template <typename Callback>
+            void ForEachDistance(Callback callback) const {
+                stop_distances_.ForEach([this, &callback](StopId from, StopId to, int distance) {
+                    callback(stop_objects_[from], stop_objects_[to], distance);
+                });
+            }
+
+            // Увеличивается при каждом изменении остановок, маршрутов или расстояний
+            uint64_t GetVersion() const;
 
         private:
+            Stop* GetOrAddStop(std::string_view name);
+            BusInfo ComputeBusInfo(const BusRoute& bus) const;
+            RouteDistances ComputeRouteDistances(const BusRoute& bus) const;
+
+            struct CachedBusInfo {
+                std::atomic<uint64_t> version = 0; // 0 - значение не вычислено
+                BusInfo info;
+            };
+
+            struct CachedRouteDistances {
+                std::atomic<uint64_t> version = 0;
+                RouteDistances distances;
+            };
+
             std::unordered_map<std::string_view, Stop*> stops_;
             std::unordered_map<std::string_view, BusRoute*> buses_;
-            std::unordered_map<std::string_view, std::unordered_set<std::string_view>> stop_to_buses_;
-            std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopPairHasher> stop_distances_;
+            // индекс - StopId
+            std::vector<std::unordered_set<std::string_view>> stop_to_buses_;
+            DistanceTable stop_distances_;
 
+            // индексы в очередях совпадают с StopId и BusId
             std::deque<Stop> stop_objects_;
             std::deque<BusRoute> bus_objects_;
+
+            uint64_t version_ = 1;
+            // индекс - BusId
+            mutable std::deque<CachedBusInfo> bus_info_cache_;
+            mutable std::deque<CachedRouteDistances> route_distances_cache_;
+            mutable std::mutex bus_info_mutex_;
         };
 
     } // namespace catalogue
@@ -1,7 +1,7 @@
 // transport_router.cpp
 
 #include "transport_router.h"
-#include "log_duration.h"
+#include "profiler.h"
 
 #include <unordered_map>
 #include <vector>
@@ -21,137 +21,240 @@ namespace transport {
 
       
         TransportRouter::TransportRouter(const RoutingSettings& settings, const TransportCatalogue& catalogue)
-            : settings_(settings), buses_(catalogue.GetAllBuses()), stops_(catalogue.GetAllStops()) {
-            LOG_DURATION("Transport Router construction");
+            : settings_(settings), catalogue_(catalogue) {
+            PROFILE_SCOPE("Transport Router construction");
             BuildGraph(catalogue);
         }
 
-        DirectedWeightedGraph<double> TransportRouter::BuildGraphFromStops() {
-            DirectedWeightedGraph<double> graph(stops_.size());
-            VertexId vertex_id = 0;
+        TransportRouter::TransportRouter(const TransportCatalogue& catalogue, std::istream& snapshot)
+            : catalogue_(catalogue) {
+            PROFILE_SCOPE("Transport Router loading");
+            settings_ = serialization::ReadPod<RoutingSettings>(snapshot);
+            graph_.emplace(DirectedWeightedGraph<double>::Load(snapshot, [&catalogue](const std::string& bus_name) -> BusName {
+                const BusRoute* bus = catalogue.FindBus(bus_name);
+                if (!bus) {
+                    throw serialization::FormatError("Unknown bus in snapshot: " + bus_name);
+                }
+                return bus->name;
+            }));
+            // В модели пар остановок вершины - только остановки, в модели перегонов к ним добавляются вершины маршрутов
+            const size_t stop_count = catalogue.GetStopCount();
+            const size_t vertex_count = graph_->GetVertexCount();
+            if (settings_.graph_model == GraphModel::STOP_PAIRS ? vertex_count != stop_count
+                : settings_.graph_model != GraphModel::RIDE_SEGMENTS || vertex_count < stop_count) {
+                throw serialization::FormatError("Graph in snapshot doesn't match the catalogue");
+            }
+            router_.emplace(Router<double>::Load(graph_.value(), snapshot));
+        }
 
-            for (const auto& [stop_name, stop] : stops_) {
-                stop_to_vertex_id[stop_name] = vertex_id;
-                vertex_id_to_stop[vertex_id] = stop_name;
-                ++vertex_id;
+        void TransportRouter::Save(std::ostream& output) const {
+            serialization::WritePod(output, settings_);
+            graph_->Save(output);
+            router_->Save(output);
+        }
+
+        // Вершина остановки совпадает с её StopId
+        DirectedWeightedGraph<double> TransportRouter::BuildGraphFromStops() {
+            size_t vertex_count = catalogue_.GetStopCount();
+            if (settings_.graph_model == GraphModel::RIDE_SEGMENTS) {
+                // по вершине на каждую позицию маршрута, для некольцевых - в обе стороны
+                for (BusId bus_id = 0; bus_id < catalogue_.GetBusCount(); ++bus_id) {
+                    const BusRoute& bus = catalogue_.GetBus(bus_id);
+                    vertex_count += bus.is_circular ? bus.stops.size() : 2 * bus.stops.size();
+                }
             }
-            return graph;
+            return DirectedWeightedGraph<double>(vertex_count);
         }
 
         void TransportRouter::FillGraph(DirectedWeightedGraph<double>& graph, const TransportCatalogue& catalogue) {
-            for (const auto& [bus_name, bus] : buses_) {
+            if (settings_.graph_model == GraphModel::RIDE_SEGMENTS) {
+                FillRideSegmentsGraph(graph, catalogue);
+            }
+            else {
+                FillStopPairsGraph(graph, catalogue);
+            }
+            graph_.emplace(std::move(graph));
+        }
+
+        size_t TransportRouter::GetEdgeCount() const {
+            return graph_ ? graph_->GetEdgeCount() : 0;
+        }
 
-                const auto& stops_local = bus->stops;
+        void TransportRouter::FillStopPairsGraph(DirectedWeightedGraph<double>& graph, const TransportCatalogue& catalogue) const {
+            for (BusId bus_id = 0; bus_id < catalogue.GetBusCount(); ++bus_id) {
+                const BusRoute& bus = catalogue.GetBus(bus_id);
+                const std::string_view bus_name = bus.name;
+
+                const auto& stops_local = bus.stops;
                 const size_t stop_count = stops_local.size();
+                // Путь между любыми позициями маршрута - разность накопленных расстояний
+                const RouteDistances& distances = catalogue.GetRouteDistances(bus_id);
 
                 for (size_t i = 0; i < stop_count; ++i) {
-                    VertexId from_vertex = stop_to_vertex_id.at(stops_local[i]);
-                    double total_distance = 0;
-                    double total_reverse_distance = 0;
+                    VertexId from_vertex = stops_local[i];
 
                     for (size_t j = i + 1; j < stop_count; ++j) {
-                        VertexId to_vertex = stop_to_vertex_id.at(stops_local[j]);
+                        VertexId to_vertex = stops_local[j];
 
-                        auto distance = catalogue.GetDistance(stops_local[j - 1], stops_local[j]);
-                        if (distance) {
-                            total_distance += distance.value();
-                            double travel_time = total_distance / (settings_.bus_velocity * SPEED_CONVERTION_RATIO) + settings_.bus_wait_time;
+                        if (distances.ForwardKnown(j)) {
+                            double travel_time = distances.Forward(i, j) / (settings_.bus_velocity * SPEED_CONVERTION_RATIO) + settings_.bus_wait_time;
 
                             graph.AddEdge({ bus_name, from_vertex, to_vertex, travel_time });
                         }
 
-                        if (!bus->is_circular) {
-                            auto reverse_distance = catalogue.GetDistance(stops_local[j], stops_local[j - 1]);
-                            if (reverse_distance) {
-                                total_reverse_distance += reverse_distance.value();
-                                double reverse_travel_time = total_reverse_distance / (settings_.bus_velocity * SPEED_CONVERTION_RATIO) + settings_.bus_wait_time;
-
-                                graph.AddEdge({ bus_name, to_vertex, from_vertex, reverse_travel_time });
-                            }
+                        if (!bus.is_circular && distances.BackwardKnown(j)) {
+                            double reverse_travel_time = distances.Backward(j, i) / (settings_.bus_velocity * SPEED_CONVERTION_RATIO) + settings_.bus_wait_time;
 
+                            graph.AddEdge({ bus_name, to_vertex, from_vertex, reverse_travel_time });
                         }
 
                     }
                 }
             }
-            graph_.emplace(graph);
+        }
+
+        void TransportRouter::FillRideSegmentsGraph(DirectedWeightedGraph<double>& graph, const TransportCatalogue& catalogue) const {
+            VertexId next_vertex = catalogue.GetStopCount();
+            for (BusId bus_id = 0; bus_id < catalogue.GetBusCount(); ++bus_id) {
+                const BusRoute& bus = catalogue.GetBus(bus_id);
+                const RouteDistances& distances = catalogue.GetRouteDistances(bus_id);
+                AddRideChain(graph, bus, distances, false, next_vertex);
+                if (!bus.is_circular) {
+                    AddRideChain(graph, bus, distances, true, next_vertex);
+                }
+            }
+        }
+
+        // Цепочка вершин "в автобусе на i-й остановке маршрута":
+        // посадка (ожидание) с остановки, перегон до следующей позиции и выход на остановку
+        void TransportRouter::AddRideChain(DirectedWeightedGraph<double>& graph, const BusRoute& bus, const RouteDistances& distances,
+            bool reversed, VertexId& next_vertex) const {
+            const std::string_view bus_name = bus.name;
+            const std::vector<StopId>& stops = bus.stops;
+            const size_t stop_count = stops.size();
+            auto stop_at = [&](size_t position) {
+                return reversed ? stops[stop_count - 1 - position] : stops[position];
+            };
+
+            const VertexId first_vertex = next_vertex;
+            next_vertex += stop_count;
+            for (size_t position = 0; position < stop_count; ++position) {
+                const VertexId stop_vertex = stop_at(position);
+                const VertexId ride_vertex = first_vertex + position;
+
+                if (position > 0) {
+                    graph.AddEdge({ bus_name, ride_vertex, stop_vertex, 0.0 });
+                }
+                if (position + 1 < stop_count) {
+                    graph.AddEdge({ bus_name, stop_vertex, ride_vertex, static_cast<double>(settings_.bus_wait_time) });
+
+                    // В обратном направлении перегон идёт с позиции index к index - 1 исходного маршрута
+                    const size_t index = reversed ? stop_count - 1 - position : position + 1;
+                    if (reversed ? distances.BackwardKnown(index) : distances.ForwardKnown(index)) {
+                        const double distance = reversed ? distances.Backward(index, index - 1) : distances.Forward(index - 1, index);
+                        double travel_time = distance / (settings_.bus_velocity * SPEED_CONVERTION_RATIO);
+                        graph.AddEdge({ bus_name, ride_vertex, ride_vertex + 1, travel_time });
+                    }
+                }
+            }
         }
 
         void TransportRouter::BuildGraph(const TransportCatalogue& catalogue) {
-            LOG_DURATION("BuildGraph");
+            PROFILE_SCOPE("BuildGraph");
             auto graph = BuildGraphFromStops();
             FillGraph(graph, catalogue);
-            router_.emplace(graph_.value());
+            graph_->Freeze();
+            PROFILE_SCOPE("Router preprocessing");
+            router_.emplace(graph_.value(), settings_.router_mode);
         }
 
         std::optional<std::tuple<double, std::vector<RouteItem>>> TransportRouter::GetRoute(
             const std::string_view from, const std::string_view to) const {
-            LOG_DURATION("Get Route");
+            PROFILE_SCOPE("Get Route");
 
-            auto from_stop_it = stop_to_vertex_id.find(from);
-            auto to_stop_it = stop_to_vertex_id.find(to);
+            const Stop* from_stop = catalogue_.FindStop(from);
+            const Stop* to_stop = catalogue_.FindStop(to);
 
-            if (from_stop_it == stop_to_vertex_id.end() || to_stop_it == stop_to_vertex_id.end() || !graph_.has_value()) {
+            if (!from_stop || !to_stop || !graph_.has_value()) {
                 return std::nullopt;
             }
 
 
-            VertexId from_vertex = from_stop_it->second;
-            VertexId to_vertex = to_stop_it->second;
+            VertexId from_vertex = from_stop->id;
+            VertexId to_vertex = to_stop->id;
 
             auto route_info = router_.value().BuildRoute(from_vertex, to_vertex);
             if (route_info) {
-                double total_time = 0.0;
                 std::vector<RouteItem> route_items;
 
-                if (from_stop_it != to_stop_it) {
-
-                    route_items.push_back(RouteItem{
-                        .type = "Wait",
-                        .name = std::string(vertex_id_to_stop.at(from_vertex)),
-                        .time = static_cast<double>(settings_.bus_wait_time)
-                        });
-                    total_time += settings_.bus_wait_time;
-
-                    std::string current_bus;
-                    for (const auto& edge_id : route_info->edges) {
-
-
-                        const auto& edge = graph_.value().GetEdge(edge_id);
-
-                        double edge_time = edge.weight - settings_.bus_wait_time; 
-
-                        std::string_view bus_name = edge.bus;
-
-                        if ((bus_name != current_bus && !current_bus.empty()) || (buses_.at(bus_name)->is_circular && edge.to == to_vertex && edge.from != from_vertex)) {
-                            
-                            route_items.push_back(RouteItem{
-                                .type = "Wait",
-                                .name = std::string(vertex_id_to_stop.at(edge.from)),
-                                .time = static_cast<double>(settings_.bus_wait_time)
-                                });
-                            total_time += settings_.bus_wait_time;
-                        }
-
-                        route_items.push_back(RouteItem{
-                            .type = "Bus",
-                            .name = std::string(bus_name),
-                            .span_count = 0,
-                            .time = edge_time
-                            });
-                        total_time += edge_time;
-
-                        current_bus = bus_name;
-                    }
+                if (from_vertex != to_vertex) {
+                    route_items = settings_.graph_model == GraphModel::RIDE_SEGMENTS
+                        ? MakeRideSegmentsItems(route_info->edges)
+                        : MakeStopPairsItems(route_info->edges);
                 }
 
-                return std::make_tuple(total_time, route_items);
+                // Вес маршрута уже учитывает каждую посадку, поэтому не зависит от того,
+                // какой из равных по времени путей выбрал маршрутизатор
+                return std::make_tuple(route_info->weight, route_items);
             }
             else {
                 return std::nullopt; 
             }
         }
 
+        // Каждое ребро - отдельная поездка с посадкой, даже если соседние рёбра одного автобуса:
+        // ожидание входит в вес ребра, поэтому Wait выводится перед каждым Bus
+        std::vector<RouteItem> TransportRouter::MakeStopPairsItems(const std::vector<EdgeId>& edges) const {
+            std::vector<RouteItem> route_items;
+            route_items.reserve(2 * edges.size());
+
+            for (const auto& edge_id : edges) {
+                const auto& edge = graph_.value().GetEdge(edge_id);
+
+                route_items.push_back(RouteItem{
+                    .type = "Wait",
+                    .name = catalogue_.GetStop(edge.from).name,
+                    .time = static_cast<double>(settings_.bus_wait_time)
+                    });
+
+                route_items.push_back(RouteItem{
+                    .type = "Bus",
+                    .name = std::string(edge.bus),
+                    .span_count = 0,
+                    .time = edge.weight - settings_.bus_wait_time
+                    });
+            }
+            return route_items;
+        }
+
+        // Рёбра посадки начинаются в вершине-остановке, рёбра выхода в ней заканчиваются,
+        // а идущие подряд перегоны одного автобуса сливаются в один элемент Bus
+        std::vector<RouteItem> TransportRouter::MakeRideSegmentsItems(const std::vector<EdgeId>& edges) const {
+            const VertexId stop_vertex_count = catalogue_.GetStopCount();
+            std::vector<RouteItem> route_items;
+
+            for (const auto& edge_id : edges) {
+                const auto edge = graph_.value().GetEdge(edge_id);
+                if (edge.from < stop_vertex_count) {
+                    route_items.push_back(RouteItem{
+                        .type = "Wait",
+                        .name = catalogue_.GetStop(edge.from).name,
+                        .time = edge.weight
+                        });
+                    route_items.push_back(RouteItem{
+                        .type = "Bus",
+                        .name = std::string(edge.bus),
+                        .span_count = 0,
+                        .time = 0.0
+                        });
+                }
+                else if (edge.to >= stop_vertex_count) {
+                    route_items.back().time += edge.weight;
+                }
+            }
+            return route_items;
+        }
+
     } // namespace catalogue
 } // namespace transport
 
@@ -5,6 +5,7 @@
 #include "transport_catalogue.h"
 #include "router.h"
 
+#include <iosfwd>
 #include <optional>
 #include <string>
 #include <vector>
@@ -14,9 +15,18 @@ using namespace graph;
 namespace transport {
     namespace catalogue {
 
+        enum class GraphModel {
+            //       , O(n^2)   
+            STOP_PAIRS,
+            //  "   "   ,   , O(n)   
+            RIDE_SEGMENTS,
+        };
+
         struct RoutingSettings {
             int bus_velocity = 0;
             int bus_wait_time = 0;
+            RouterMode router_mode = RouterMode::DIJKSTRA;
+            GraphModel graph_model = GraphModel::STOP_PAIRS;
         };
 
         struct RouteItem {
@@ -30,24 +40,34 @@ namespace transport {
         class TransportRouter {
         public:
             TransportRouter(const RoutingSettings& settings, const TransportCatalogue& catalogue);
+            //    ,  Save,   
+            TransportRouter(const TransportCatalogue& catalogue, std::istream& snapshot);
+
+            void Save(std::ostream& output) const;
 
             DirectedWeightedGraph<double> BuildGraphFromStops();
            
             void BuildGraph(const TransportCatalogue& catalogue);
             void FillGraph(DirectedWeightedGraph<double>& graph, const TransportCatalogue& catalogue);
 
+            size_t GetEdgeCount() const;
+
             std::optional<std::tuple<double, std::vector<RouteItem>>> GetRoute(const std::string_view from, const std::string_view to) const;
 
         private:
+            void FillStopPairsGraph(DirectedWeightedGraph<double>& graph, const TransportCatalogue& catalogue) const;
+            void FillRideSegmentsGraph(DirectedWeightedGraph<double>& graph, const TransportCatalogue& catalogue) const;
+            void AddRideChain(DirectedWeightedGraph<double>& graph, const BusRoute& bus, const RouteDistances& distances,
+                bool reversed, VertexId& next_vertex) const;
+
+            std::vector<RouteItem> MakeStopPairsItems(const std::vector<EdgeId>& edges) const;
+            std::vector<RouteItem> MakeRideSegmentsItems(const std::vector<EdgeId>& edges) const;
+
             RoutingSettings settings_;
-            
-            std::unordered_map<std::string_view, VertexId> stop_to_vertex_id;
-            std::unordered_map<VertexId, std::string_view> vertex_id_to_stop;
+            const TransportCatalogue& catalogue_;
 
             std::optional<DirectedWeightedGraph<double>> graph_;
             std::optional<Router<double>> router_;
-            std::unordered_map<std::string_view, BusRoute*> buses_;
-            std::unordered_map<std::string_view, Stop*> stops_;
         };
 
     } // namespace catalogue